@@ -0,0 +1,70 @@
+#include "AsyncIO.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Worker threads draining a shared job queue
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t thread_count) {
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    // Finish the queued jobs, then stop the workers
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void enqueue(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            // Jobs are packaged tasks, which capture their own exceptions
+            job();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+} // namespace
+
+// Queue a job on the shared pool, starting the pool on first use
+void AsyncIO::enqueue(std::function<void()> job) {
+    static ThreadPool pool(THREAD_COUNT);
+    pool.enqueue(std::move(job));
+}
@@ -0,0 +1,36 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
+// A small shared thread pool for file I/O, so that loads and saves can
+// overlap with computation on the calling thread. Tasks run in submission
+// order on up to THREAD_COUNT threads, started on first use. Pending tasks
+// are finished before the program exits.
+class AsyncIO {
+public:
+    static const std::size_t THREAD_COUNT = 4;
+
+    // Run task on the pool; its result, or the exception it throws, is
+    // delivered through the returned future
+    template <typename Task>
+    static auto submit(Task task) -> std::future<decltype(task())>;
+
+private:
+    static void enqueue(std::function<void()> job);
+};
+
+template <typename Task>
+auto AsyncIO::submit(Task task) -> std::future<decltype(task())> {
+    // std::function needs a copyable callable, so the task is shared
+    auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+    auto result = packaged->get_future();
+    enqueue([packaged]() { (*packaged)(); });
+    return result;
+}
+
+#endif // ASYNC_IO_H
@@ -2,6 +2,25 @@
 #include <stdexcept>
 #include <bitset>
 #include <vector>
+#include <cstdint>
+
+namespace {
+
+// Header written in bit 0 of the first HEADER_PIXELS pixels, row by row:
+// 8-bit magic, 8-bit format (version in the high nibble, bits per pixel in
+// the low nibble) and the 32-bit message length in bytes, most significant
+// bit first. The payload follows in the lowest bits_per_pixel bits.
+const int HEADER_MAGIC = 0xC7;
+const int HEADER_VERSION = 1;
+const int HEADER_PIXELS = 48;
+
+void check_bits_per_pixel(int bits_per_pixel) {
+    if (bits_per_pixel < 1 || bits_per_pixel > 4) {
+        throw std::invalid_argument("Bits per pixel must be between 1 and 4.");
+    }
+}
+
+} // namespace
 
 // Extract the least significant bits (LSBs) from SecretImage, calculating x, y based on message length
 std::vector<int> Crypto::extract_LSBits(SecretImage& secret_image, int message_length) {
@@ -11,7 +30,7 @@ std::vector<int> Crypto::extract_LSBits(SecretImage& secret_image, int message_l
     // 1. Reconstruct the SecretImage to a GrayscaleImage.
     // 2. Calculate the image dimensions.
 
-    GrayscaleImage image = secret_image.reconstruct();
+    const GrayscaleImage image = secret_image.reconstruct();
     int width = image.get_width();
     int height = image.get_height();
 
@@ -28,19 +47,14 @@ std::vector<int> Crypto::extract_LSBits(SecretImage& secret_image, int message_l
 
     // 5. Calculate the starting pixel from the message_length knowing that
     //    the last LSB to extract is in the last pixel of the image.
-
-    int bit_index = 0;
-    for (int i = height - 1; i >= 0 && bit_index < total_bits; --i) {
-        for (int j = width - 1; j >= 0 && bit_index < total_bits; --j) {
-            int pixel_value = image.get_pixel(i, j);
-            int lsb = pixel_value & 1; // En az anlamlı bit
-            LSB_array.push_back(lsb);
-            bit_index++;
-        }
-    }
+    int start_pixel = total_pixels - total_bits;
 
     // 6. Extract LSBs from the image pixels and return the result.
-    std::reverse(LSB_array.begin(), LSB_array.end());
+    const int* pixel_values = image.pixels();
+    LSB_array.reserve(total_bits);
+    for (int p = start_pixel; p < total_pixels; ++p) {
+        LSB_array.push_back(pixel_values[p] & 1); // En az anlamlı bit
+    }
 
     return LSB_array;
 }
@@ -109,30 +123,13 @@ SecretImage Crypto::embed_LSBits(GrayscaleImage& image, const std::vector<int>&
 
     // 2. Find the starting pixel based on the message length knowing that
     //    the last LSB to embed should end up in the last pixel of the image.
-    int bit_index = 0;
     int start_pixel = total_pixels - total_bits;  // Position where the first bit will be embedded
 
     // 3. Iterate over the image pixels, embedding LSBs from the array.
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int pixel_position = i * width + j;
-
-            if (pixel_position >= start_pixel && bit_index < total_bits) {
-                int pixel_value = image.get_pixel(i, j);
-
-                int current_lsb = pixel_value & 1;
-                if (current_lsb != LSB_array[bit_index]) {
-                    if (LSB_array[bit_index] == 1) {
-                        pixel_value |= 1;
-                    } else {
-                        pixel_value &= ~1;
-                    }
-                }
-
-                image.set_pixel(i, j, pixel_value);
-                bit_index++;
-            }
-        }
+    int* pixel_values = image.pixels();
+    for (int bit_index = 0; bit_index < total_bits; ++bit_index) {
+        int& pixel_value = pixel_values[start_pixel + bit_index];
+        pixel_value = (pixel_value & ~1) | (LSB_array[bit_index] & 1);
     }
 
     // 4. Return a SecretImage object constructed from the given GrayscaleImage
@@ -141,3 +138,101 @@ SecretImage Crypto::embed_LSBits(GrayscaleImage& image, const std::vector<int>&
     return secret_image;
 }
 
+// Number of message bytes that fit after the header
+std::size_t Crypto::message_capacity(const GrayscaleImage& image, int bits_per_pixel) {
+    check_bits_per_pixel(bits_per_pixel);
+    std::size_t total_pixels = static_cast<std::size_t>(image.get_width()) * image.get_height();
+    if (total_pixels <= static_cast<std::size_t>(HEADER_PIXELS)) {
+        return 0;
+    }
+    return (total_pixels - HEADER_PIXELS) * bits_per_pixel / 8;
+}
+
+// Embed a header and the message bytes into the lowest bit planes of the image
+SecretImage Crypto::embed_message(GrayscaleImage& image, const std::string& message, int bits_per_pixel) {
+
+    // 1. Ensure the image can hold the header and the whole message.
+    if (message.size() > message_capacity(image, bits_per_pixel) || message.size() > 0xFFFFFFFFu) {
+        throw std::runtime_error("Image does not have enough pixels to embed the message.");
+    }
+
+    int* pixel_values = image.pixels();
+    std::uint64_t header = (static_cast<std::uint64_t>(HEADER_MAGIC) << 40) |
+                           (static_cast<std::uint64_t>((HEADER_VERSION << 4) | bits_per_pixel) << 32) |
+                           static_cast<std::uint64_t>(message.size());
+
+    // 2. Write the header one bit per pixel.
+    for (int p = 0; p < HEADER_PIXELS; ++p) {
+        int bit = static_cast<int>((header >> (HEADER_PIXELS - 1 - p)) & 1);
+        pixel_values[p] = (pixel_values[p] & ~1) | bit;
+    }
+
+    // 3. Write the message bytes bits_per_pixel bits at a time, most
+    //    significant bit first, padding the last pixel with zeros.
+    int mask = (1 << bits_per_pixel) - 1;
+    std::size_t payload_pixels = (message.size() * 8 + bits_per_pixel - 1) / bits_per_pixel;
+    std::uint32_t buffer = 0;
+    int buffered_bits = 0;
+    std::size_t next_byte = 0;
+    for (std::size_t p = HEADER_PIXELS; p < HEADER_PIXELS + payload_pixels; ++p) {
+        if (buffered_bits < bits_per_pixel) {
+            unsigned char byte = next_byte < message.size() ? static_cast<unsigned char>(message[next_byte]) : 0;
+            ++next_byte;
+            buffer = (buffer << 8) | byte;
+            buffered_bits += 8;
+        }
+        buffered_bits -= bits_per_pixel;
+        int bits = static_cast<int>((buffer >> buffered_bits) & mask);
+
+        pixel_values[p] = (pixel_values[p] & ~mask) | bits;
+    }
+
+    // 4. Return a SecretImage built from the modified image.
+    return SecretImage(image);
+}
+
+// Read the header, then the message bytes it describes
+std::string Crypto::extract_message(SecretImage& secret_image) {
+
+    const GrayscaleImage image = secret_image.reconstruct();
+    const int* pixel_values = image.pixels();
+    std::size_t total_pixels = static_cast<std::size_t>(image.get_width()) * image.get_height();
+
+    // 1. Read and validate the header.
+    if (total_pixels < static_cast<std::size_t>(HEADER_PIXELS)) {
+        throw std::runtime_error("Image is too small to contain a message header.");
+    }
+    std::uint64_t header = 0;
+    for (int p = 0; p < HEADER_PIXELS; ++p) {
+        header = (header << 1) | (pixel_values[p] & 1);
+    }
+
+    int magic = static_cast<int>((header >> 40) & 0xFF);
+    int format = static_cast<int>((header >> 32) & 0xFF);
+    int bits_per_pixel = format & 0x0F;
+    std::size_t length = static_cast<std::size_t>(header & 0xFFFFFFFFu);
+    if (magic != HEADER_MAGIC || (format >> 4) != HEADER_VERSION || bits_per_pixel < 1 || bits_per_pixel > 4) {
+        throw std::runtime_error("Image does not contain a message header.");
+    }
+    if (length > message_capacity(image, bits_per_pixel)) {
+        throw std::runtime_error("Message length in header exceeds the image capacity.");
+    }
+
+    // 2. Collect bits_per_pixel bits from each payload pixel into bytes.
+    int mask = (1 << bits_per_pixel) - 1;
+    std::string message;
+    message.reserve(length);
+    std::uint32_t buffer = 0;
+    int buffered_bits = 0;
+    for (std::size_t p = HEADER_PIXELS; message.size() < length; ++p) {
+        buffer = (buffer << bits_per_pixel) | (pixel_values[p] & mask);
+        buffered_bits += bits_per_pixel;
+        if (buffered_bits >= 8) {
+            buffered_bits -= 8;
+            message += static_cast<char>((buffer >> buffered_bits) & 0xFF);
+            buffer &= (1u << buffered_bits) - 1;
+        }
+    }
+
+    return message;
+}
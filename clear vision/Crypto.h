@@ -22,6 +22,17 @@ public:
 
     // Function to embed LSB array into SecretImage
     static SecretImage embed_LSBits(GrayscaleImage& image, const std::vector<int>& LSB_array);
+
+    // Function to embed a message of 8-bit bytes into the lowest bits_per_pixel
+    // bit planes (1-4), preceded by a header recording the mode and length
+    static SecretImage embed_message(GrayscaleImage& image, const std::string& message, int bits_per_pixel = 1);
+
+    // Function to extract a message written by embed_message, reading the
+    // mode and length from its header
+    static std::string extract_message(SecretImage& secret_image);
+
+    // Function to compute how many message bytes an image can carry
+    static std::size_t message_capacity(const GrayscaleImage& image, int bits_per_pixel);
 };
 
 #endif // CRYPTO_H
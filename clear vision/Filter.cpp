@@ -9,65 +9,156 @@
 #include <cmath>
 #include "Filter.h"
 #include "GrayscaleImage.h"
+#include "ImageView.h"
+#include "MemoryTracker.h"
 #include <algorithm>
+#include <list>
+#include <mutex>
+
+namespace {
+
+enum FilterKind { MEAN_FILTER, GAUSSIAN_FILTER, UNSHARP_FILTER };
+
+// A memoized filter result
+struct CacheEntry {
+    std::uint64_t hash;
+    int width, height;
+    FilterKind kind;
+    int kernelSize;
+    double parameter;
+    GrayscaleImage result;
+};
+
+std::mutex cache_mutex;
+std::list<CacheEntry> cache;  // Most recently used first
+std::size_t cache_capacity = 0;  // 0 disables the cache
+
+// Look up a memoized result; on a hit, replace the image with it
+bool cache_lookup(GrayscaleImage& image, std::uint64_t hash, FilterKind kind, int kernelSize, double parameter) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        if (it->hash == hash && it->width == image.get_width() && it->height == image.get_height() &&
+            it->kind == kind && it->kernelSize == kernelSize && it->parameter == parameter) {
+            cache.splice(cache.begin(), cache, it);
+            image = it->result;
+            return true;
+        }
+    }
+    return false;
+}
 
-// Mean Filter
-void Filter::apply_mean_filter(GrayscaleImage& image, int kernelSize) {
-
-    // Ensure kernel size is odd
-    if (kernelSize % 2 == 0) {
-        throw std::invalid_argument("Kernel size must be odd.");
+// Remember a result, evicting the least recently used entry when full
+void cache_store(const GrayscaleImage& result, std::uint64_t hash, int width, int height,
+                 FilterKind kind, int kernelSize, double parameter) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cache_capacity == 0) {
+        return;
+    }
+    while (cache.size() >= cache_capacity) {
+        cache.pop_back();
     }
 
-    int width = image.get_width();
-    int height = image.get_height();
-    int halfKernel = kernelSize / 2;
+    // Memoization is best-effort: skip results that do not fit in the memory budget
+    try {
+        cache.push_front({hash, width, height, kind, kernelSize, parameter, result});
+    } catch (const MemoryBudgetExceeded&) {
+    }
+}
 
-    // Create a new image to store the filtered result
-    GrayscaleImage filteredImage(width, height);
-
-    // Loop over each pixel in the image
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int sum = 0;
-            int count = 0;
-
-            // Iterate over the kernel
-            for (int ky = -halfKernel; ky <= halfKernel; ++ky) {
-                for (int kx = -halfKernel; kx <= halfKernel; ++kx) {
-                    int neighborX = x + kx;
-                    int neighborY = y + ky;
-
-                    // Check if the neighbor is within image bounds
-                    if (neighborX >= 0 && neighborX < width && neighborY >= 0 && neighborY < height) {
-                        sum += image.get_pixel(neighborX, neighborY);
-                        count++;
-                    } else {
-                        // Out of bounds, treat as black pixel (0)
-                        sum += 0;
-                        count++;
-                    }
-                }
-            }
+bool cache_enabled() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_capacity > 0;
+}
 
-            // Calculate the mean value and set the pixel in the filtered image
-            int meanValue = (count > 0) ? (sum / count) : 0; // Avoid division by zero
-            filteredImage.set_pixel(x, y, meanValue); // Set the pixel value in the filtered image
+// A rectangle of the source image to filter
+struct Region {
+    int row, col;
+    int height, width;
+};
+
+// Source rows of an image that is being filtered in place strip by strip.
+// Rows above the current strip have already been overwritten, so their
+// original values come from a saved copy instead.
+class StripSource {
+public:
+    StripSource(const GrayscaleImage& image, const std::vector<int>& saved, int saved_first, int strip_first)
+        : image(image), saved(saved), saved_first(saved_first), strip_first(strip_first) {}
+
+    int get_width() const { return image.get_width(); }
+    int get_height() const { return image.get_height(); }
+    const int* row(int y) const {
+        if (y < strip_first) {
+            return saved.data() + static_cast<size_t>(y - saved_first) * image.get_width();
         }
+        return image.row(y);
     }
 
-    // Replace the original image with the filtered image
-    image = filteredImage;
+private:
+    const GrayscaleImage& image;
+    const std::vector<int>& saved;
+    int saved_first;  // Image row held at the start of saved
+    int strip_first;  // First row not yet overwritten
+};
+
+// Scratch bytes used by the region cores below for a region of the given
+// size. The cores do not account for it themselves: callers reserve it
+// before writing any output, so that no run can fail halfway.
+std::size_t mean_scratch(int width) {
+    return width * sizeof(int);
 }
 
-// Gaussian Smoothing Filter
-void Filter::apply_gaussian_smoothing(GrayscaleImage& image, int kernelSize, double sigma) {
+std::size_t gaussian_scratch(int width) {
+    return width * sizeof(double);
+}
 
-    // Ensure the kernel size is odd
-    if (kernelSize % 2 == 0) {
-        kernelSize++;  // If even, increment by 1 to make it odd
+std::size_t unsharp_scratch(int width, int height) {
+    return gaussian_scratch(width) + static_cast<size_t>(width) * height * sizeof(int);
+}
+
+// Mean filter of a region of source, written to out (out_stride ints per row).
+// Neighbors are read from the whole source image, so pixels near the edge of
+// the region see the same window as in a full-frame run. Out-of-bounds
+// neighbors count as black pixels (0), so every window is divided by the
+// full kernel area.
+template <typename Source>
+void mean_filter_region(const Source& source, const Region& region, int kernelSize,
+                        int* out, int out_stride) {
+    int imageWidth = source.get_width();
+    int imageHeight = source.get_height();
+    int halfKernel = kernelSize / 2;
+    int count = kernelSize * kernelSize;
+
+    // Sum the kernel window of a whole row at once: for every kernel offset,
+    // add the shifted source row over the columns where it is in bounds.
+    std::vector<int> sums(region.width);
+    for (int y = 0; y < region.height; ++y) {
+        std::fill(sums.begin(), sums.end(), 0);
+
+        for (int ky = -halfKernel; ky <= halfKernel; ++ky) {
+            int neighborY = region.row + y + ky;
+            if (neighborY < 0 || neighborY >= imageHeight) {
+                continue;
+            }
+            const int* sourceRow = source.row(neighborY) + region.col;
+            for (int kx = -halfKernel; kx <= halfKernel; ++kx) {
+                int first = std::max(0, -kx - region.col);
+                int last = std::min(region.width, imageWidth - kx - region.col);
+                for (int x = first; x < last; ++x) {
+                    sums[x] += sourceRow[x + kx];
+                }
+            }
+        }
+
+        // Calculate the mean values and store them in the output row
+        int* outRow = out + static_cast<size_t>(y) * out_stride;
+        for (int x = 0; x < region.width; ++x) {
+            outRow[x] = sums[x] / count;
+        }
     }
+}
 
+// Build a normalized kernelSize x kernelSize Gaussian kernel
+std::vector<std::vector<double>> gaussian_kernel(int kernelSize, double sigma) {
     int radius = kernelSize / 2;
     std::vector<std::vector<double>> kernel(kernelSize, std::vector<double>(kernelSize, 0.0));
     double sum = 0.0;
@@ -88,74 +179,324 @@ void Filter::apply_gaussian_smoothing(GrayscaleImage& image, int kernelSize, dou
         }
     }
 
-    // Create a temporary image for the result
-    GrayscaleImage result(image.get_width(), image.get_height());
+    return kernel;
+}
 
-    // Apply Gaussian smoothing
-    for (int y = 0; y < image.get_height(); ++y) {
-        for (int x = 0; x < image.get_width(); ++x) {
-            double newValue = 0.0;
+// Gaussian smoothing of a region of source, written to out (out_stride ints
+// per row). Each kernel tap is added to the whole row before moving to the
+// next tap, so every pixel still sums its in-bounds neighbors in kernel order
+// while the inner loop stays vectorizable. Out-of-bounds neighbors contribute
+// nothing (black).
+template <typename Source>
+void gaussian_region(const Source& source, const Region& region,
+                     const std::vector<std::vector<double>>& kernel, int* out, int out_stride) {
+    int imageWidth = source.get_width();
+    int imageHeight = source.get_height();
+    int radius = static_cast<int>(kernel.size()) / 2;
+
+    std::vector<double> accumulator(region.width);
+    for (int y = 0; y < region.height; ++y) {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0);
+
+        for (int ky = -radius; ky <= radius; ++ky) {
+            int pixelY = region.row + y + ky;
+            if (pixelY < 0 || pixelY >= imageHeight) {
+                continue;
+            }
+            const int* sourceRow = source.row(pixelY) + region.col;
+            const std::vector<double>& weights = kernel[ky + radius];
+            for (int kx = -radius; kx <= radius; ++kx) {
+                double weight = weights[kx + radius];
+                int first = std::max(0, -kx - region.col);
+                int last = std::min(region.width, imageWidth - kx - region.col);
+                for (int x = first; x < last; ++x) {
+                    accumulator[x] += sourceRow[x + kx] * weight;
+                }
+            }
+        }
 
-            // Apply the kernel to the current pixel
-            for (int ky = -radius; ky <= radius; ++ky) {
-                for (int kx = -radius; kx <= radius; ++kx) {
-                    int pixelY = y + ky;
-                    int pixelX = x + kx;
+        // Clamp the new pixel values to [0, 255]
+        int* outRow = out + static_cast<size_t>(y) * out_stride;
+        for (int x = 0; x < region.width; ++x) {
+            outRow[x] = static_cast<int>(std::min(std::max(accumulator[x], 0.0), 255.0));
+        }
+    }
+}
 
-                    // Handle boundary conditions
-                    int pixelValue = 0;
-                    if (pixelY >= 0 && pixelY < image.get_height() && pixelX >= 0 && pixelX < image.get_width()) {
-                        pixelValue = image.get_pixel(pixelY, pixelX);
-                    }
+// Unsharp masking of a region of source, written to out (out_stride ints per
+// row). The blur is finished before any output is written, so out may be the
+// region itself.
+template <typename Source>
+void unsharp_region(const Source& source, const Region& region, int kernelSize, double amount,
+                    int* out, int out_stride) {
 
-                    newValue += pixelValue * kernel[ky + radius][kx + radius];
-                }
-            }
+    // 1. Blur the region using Gaussian smoothing with the default sigma.
+    if (kernelSize % 2 == 0) {
+        kernelSize++;
+    }
+    std::vector<int> blurred(static_cast<size_t>(region.width) * region.height);
+    gaussian_region(source, region, gaussian_kernel(kernelSize, 1.0), blurred.data(), region.width);
 
-            // Clamp the new pixel value to [0, 255]
-            newValue = std::min(std::max(newValue, 0.0), 255.0);
+    // 2. For each pixel, apply the unsharp mask formula: original + amount * (original - blurred).
+    // 3. Clip values to ensure they are within a valid range [0-255].
+    for (int y = 0; y < region.height; ++y) {
+        const int* sourceRow = source.row(region.row + y) + region.col;
+        const int* blurredRow = blurred.data() + static_cast<size_t>(y) * region.width;
+        int* outRow = out + static_cast<size_t>(y) * out_stride;
+        for (int x = 0; x < region.width; ++x) {
+            // Unsharp Masking formula: I_sharp = I_original + amount * (I_original - I_blur)
+            double original = static_cast<double>(sourceRow[x]);
+            double edge = original - static_cast<double>(blurredRow[x]);
+            double newValue = original + amount * edge;
 
-            result.set_pixel(y, x, static_cast<int>(newValue));
+            outRow[x] = static_cast<int>(std::min(std::max(newValue, 0.0), 255.0));
         }
     }
+}
 
-    // Copy the result back to the original image
-    for (int y = 0; y < image.get_height(); ++y) {
-        for (int x = 0; x < image.get_width(); ++x) {
-            image.set_pixel(y, x, result.get_pixel(y, x));
+// Filter the whole image in place one strip of rows at a time, for when a
+// full-size result does not fit in the memory budget. Only one strip of
+// output and the `halo` original rows above it are held. filter_region
+// (source, region, out) must read no further than halo rows from the region
+// and needs fixed_scratch bytes plus row_scratch bytes per region row; all
+// of it is reserved before the first strip is written. Throws
+// MemoryBudgetExceeded, leaving the image unchanged, if not even a
+// single-row strip fits.
+template <typename RegionFilter>
+void filter_in_strips(GrayscaleImage& image, int halo, std::size_t fixed_scratch, std::size_t row_scratch,
+                      RegionFilter filter_region) {
+    int width = image.get_width();
+    int height = image.get_height();
+    if (width == 0 || height == 0) {
+        return;
+    }
+    halo = std::min(halo, height);
+
+    // Make the strips as tall as the remaining budget allows
+    std::size_t row_bytes = width * sizeof(int);
+    std::size_t budget = MemoryTracker::get_budget();
+    std::size_t used = MemoryTracker::current_bytes();
+    std::size_t available = budget > used ? budget - used : 0;
+    std::size_t fixed = halo * row_bytes + fixed_scratch;
+    if (available < fixed + row_bytes + row_scratch) {
+        throw MemoryBudgetExceeded("Filtering a " + std::to_string(width) + "x" + std::to_string(height) +
+                                   " image does not fit in the memory budget, even strip by strip.");
+    }
+    int strip_rows = static_cast<int>(std::min<std::size_t>(height, (available - fixed) / (row_bytes + row_scratch)));
+
+    MemoryReservation reservation((halo + static_cast<std::size_t>(strip_rows)) * row_bytes + fixed_scratch +
+                                  strip_rows * row_scratch);
+    std::vector<int> saved(static_cast<size_t>(halo) * width);
+    std::vector<int> strip(static_cast<size_t>(strip_rows) * width);
+    int saved_first = 0;
+
+    for (int first = 0; first < height; first += strip_rows) {
+        int rows = std::min(strip_rows, height - first);
+        StripSource source(image, saved, saved_first, first);
+        filter_region(source, Region{first, 0, rows, width}, strip.data());
+
+        // Keep the original rows the next strip reads above itself. Rows only
+        // move towards the start of saved, so copying in order is safe.
+        int next_first = first + rows;
+        int next_saved_first = std::max(0, next_first - halo);
+        for (int y = next_saved_first; y < next_first; ++y) {
+            const int* original = source.row(y);
+            int* target = saved.data() + static_cast<size_t>(y - next_saved_first) * width;
+            if (target != original) {
+                std::copy(original, original + width, target);
+            }
+        }
+        saved_first = next_saved_first;
+
+        for (int y = 0; y < rows; ++y) {
+            const int* stripRow = strip.data() + static_cast<size_t>(y) * width;
+            std::copy(stripRow, stripRow + width, image.row(first + y));
         }
     }
+}
 
+// The region covered by a view
+Region view_region(const ImageView& roi) {
+    return {roi.get_row(), roi.get_col(), roi.get_height(), roi.get_width()};
 }
 
-// Unsharp Masking Filter
-void Filter::apply_unsharp_mask(GrayscaleImage& image, int kernelSize, double amount) {
+// Copy filtered pixels (roi width ints per row) back into a view
+void write_back(ImageView& roi, const std::vector<int>& filtered) {
+    for (int y = 0; y < roi.get_height(); ++y) {
+        const int* filteredRow = filtered.data() + static_cast<size_t>(y) * roi.get_width();
+        std::copy(filteredRow, filteredRow + roi.get_width(), roi.row(y));
+    }
+}
 
-    // 1. Blur the image using Gaussian smoothing, use the default sigma given in the header.
+} // namespace
 
-    GrayscaleImage blurredImage(image);
+// Enable memoization of filter results
+void Filter::enable_cache(std::size_t max_entries) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_capacity = max_entries;
+    while (cache.size() > cache_capacity) {
+        cache.pop_back();
+    }
+}
 
-    apply_gaussian_smoothing(blurredImage, kernelSize, 1.0);
+// Disable memoization and drop all cached results
+void Filter::disable_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_capacity = 0;
+    cache.clear();
+}
 
-    // 2. For each pixel, apply the unsharp mask formula: original + amount * (original - blurred).
-    // 3. Clip values to ensure they are within a valid range [0-255].
+// Drop all cached results
+void Filter::clear_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+}
 
-    for (int y = 0; y < image.get_height(); ++y) {
-        for (int x = 0; x < image.get_width(); ++x) {
-            int original = image.get_pixel(y, x);
-            int blurred = blurredImage.get_pixel(y, x);
+// Mean Filter
+void Filter::apply_mean_filter(GrayscaleImage& image, int kernelSize) {
 
-            // Unsharp Masking formula: I_sharp = I_original + amount * (I_original - I_blur)
-            double edge = static_cast<double>(original) - static_cast<double>(blurred);
-            double newValue = static_cast<double>(original) + amount * edge;
+    // Ensure kernel size is odd
+    if (kernelSize % 2 == 0) {
+        throw std::invalid_argument("Kernel size must be odd.");
+    }
 
-            if (newValue < 0.0) {
-                newValue = 0.0;
-            } else if (newValue > 255.0) {
-                newValue = 255.0;
-            }
+    bool memoize = cache_enabled();
+    std::uint64_t hash = memoize ? image.content_hash() : 0;
+    if (memoize && cache_lookup(image, hash, MEAN_FILTER, kernelSize, 0.0)) {
+        return;
+    }
 
-            image.set_pixel(y, x, static_cast<int>(newValue));
-        }
+    int width = image.get_width();
+    int height = image.get_height();
+
+    std::size_t scratch = mean_scratch(width);
+    if (MemoryTracker::would_fit(GrayscaleImage::storage_bytes(width, height) + scratch)) {
+        // Create a new image to store the filtered result
+        MemoryReservation reservation(scratch);
+        GrayscaleImage filteredImage(width, height);
+        mean_filter_region(image, {0, 0, height, width}, kernelSize, filteredImage.pixels(), width);
+
+        // Replace the original image with the filtered image
+        image = std::move(filteredImage);
+    } else {
+        // A second full-size image does not fit in the memory budget
+        filter_in_strips(image, kernelSize / 2, scratch, 0,
+                         [kernelSize](const StripSource& source, const Region& region, int* out) {
+                             mean_filter_region(source, region, kernelSize, out, region.width);
+                         });
+    }
+
+    if (memoize) {
+        cache_store(image, hash, width, height, MEAN_FILTER, kernelSize, 0.0);
     }
 }
+
+// Mean Filter restricted to a region
+void Filter::apply_mean_filter(ImageView roi, int kernelSize) {
+
+    // Ensure kernel size is odd
+    if (kernelSize % 2 == 0) {
+        throw std::invalid_argument("Kernel size must be odd.");
+    }
+
+    MemoryReservation reservation(static_cast<size_t>(roi.get_width()) * roi.get_height() * sizeof(int) +
+                                  mean_scratch(roi.get_width()));
+    std::vector<int> filtered(static_cast<size_t>(roi.get_width()) * roi.get_height());
+    mean_filter_region(roi.parent(), view_region(roi), kernelSize, filtered.data(), roi.get_width());
+    write_back(roi, filtered);
+}
+
+// Gaussian Smoothing Filter
+void Filter::apply_gaussian_smoothing(GrayscaleImage& image, int kernelSize, double sigma) {
+
+    // Ensure the kernel size is odd
+    if (kernelSize % 2 == 0) {
+        kernelSize++;  // If even, increment by 1 to make it odd
+    }
+
+    bool memoize = cache_enabled();
+    std::uint64_t hash = memoize ? image.content_hash() : 0;
+    if (memoize && cache_lookup(image, hash, GAUSSIAN_FILTER, kernelSize, sigma)) {
+        return;
+    }
+
+    int width = image.get_width();
+    int height = image.get_height();
+
+    std::vector<std::vector<double>> kernel = gaussian_kernel(kernelSize, sigma);
+    std::size_t scratch = gaussian_scratch(width);
+    if (MemoryTracker::would_fit(GrayscaleImage::storage_bytes(width, height) + scratch)) {
+        // Create a temporary image for the result
+        MemoryReservation reservation(scratch);
+        GrayscaleImage result(width, height);
+        gaussian_region(image, {0, 0, height, width}, kernel, result.pixels(), width);
+
+        // Move the result into the original image
+        image = std::move(result);
+    } else {
+        // A second full-size image does not fit in the memory budget
+        filter_in_strips(image, kernelSize / 2, scratch, 0,
+                         [&kernel](const StripSource& source, const Region& region, int* out) {
+                             gaussian_region(source, region, kernel, out, region.width);
+                         });
+    }
+
+    if (memoize) {
+        cache_store(image, hash, width, height, GAUSSIAN_FILTER, kernelSize, sigma);
+    }
+}
+
+// Gaussian Smoothing Filter restricted to a region
+void Filter::apply_gaussian_smoothing(ImageView roi, int kernelSize, double sigma) {
+
+    // Ensure the kernel size is odd
+    if (kernelSize % 2 == 0) {
+        kernelSize++;  // If even, increment by 1 to make it odd
+    }
+
+    MemoryReservation reservation(static_cast<size_t>(roi.get_width()) * roi.get_height() * sizeof(int) +
+                                  gaussian_scratch(roi.get_width()));
+    std::vector<int> filtered(static_cast<size_t>(roi.get_width()) * roi.get_height());
+    gaussian_region(roi.parent(), view_region(roi), gaussian_kernel(kernelSize, sigma), filtered.data(), roi.get_width());
+    write_back(roi, filtered);
+}
+
+// Unsharp Masking Filter
+void Filter::apply_unsharp_mask(GrayscaleImage& image, int kernelSize, double amount) {
+
+    bool memoize = cache_enabled();
+    std::uint64_t hash = memoize ? image.content_hash() : 0;
+    if (memoize && cache_lookup(image, hash, UNSHARP_FILTER, kernelSize, amount)) {
+        return;
+    }
+
+    // Sharpen in place: only the blur needs a scratch buffer
+    int width = image.get_width();
+    int height = image.get_height();
+    std::size_t scratch = gaussian_scratch(width);
+    std::size_t row_scratch = width * sizeof(int);
+    if (MemoryTracker::would_fit(unsharp_scratch(width, height))) {
+        MemoryReservation reservation(unsharp_scratch(width, height));
+        unsharp_region(image, {0, 0, height, width}, kernelSize, amount, image.pixels(), width);
+    } else {
+        // The full-size blur does not fit in the memory budget
+        filter_in_strips(image, (kernelSize | 1) / 2, scratch, row_scratch,
+                         [kernelSize, amount](const StripSource& source, const Region& region, int* out) {
+                             unsharp_region(source, region, kernelSize, amount, out, region.width);
+                         });
+    }
+
+    if (memoize) {
+        cache_store(image, hash, width, height, UNSHARP_FILTER, kernelSize, amount);
+    }
+}
+
+// Unsharp Masking Filter restricted to a region
+void Filter::apply_unsharp_mask(ImageView roi, int kernelSize, double amount) {
+    // Written back row by row, so that every changed tile hash is invalidated
+    MemoryReservation reservation(static_cast<size_t>(roi.get_width()) * roi.get_height() * sizeof(int) +
+                                  unsharp_scratch(roi.get_width(), roi.get_height()));
+    std::vector<int> filtered(static_cast<size_t>(roi.get_width()) * roi.get_height());
+    unsharp_region(roi.parent(), view_region(roi), kernelSize, amount, filtered.data(), roi.get_width());
+    write_back(roi, filtered);
+}
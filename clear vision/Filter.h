@@ -2,6 +2,8 @@
 #define FILTER_H
 
 #include "GrayscaleImage.h"
+#include "ImageView.h"
+#include <cstddef>
 
 class Filter {
 public:
@@ -13,6 +15,24 @@ public:
 
     // Apply Unsharp Masking Filter
     static void apply_unsharp_mask(GrayscaleImage& image, int kernelSize = 3, double amount = 1.5);
+
+    // When a full-size scratch buffer would exceed the MemoryTracker budget,
+    // the full-image filters above work in place strip by strip (same
+    // results, less memory); if even that does not fit, or a region variant
+    // does not fit, they throw MemoryBudgetExceeded and leave the image as is.
+
+    // Region-of-interest variants: only pixels inside the view are filtered,
+    // but neighbors are read from the parent image, so the results match a
+    // full-frame run inside the region
+    static void apply_mean_filter(ImageView roi, int kernelSize = 3);
+    static void apply_gaussian_smoothing(ImageView roi, int kernelSize = 3, double sigma = 1.0);
+    static void apply_unsharp_mask(ImageView roi, int kernelSize = 3, double amount = 1.5);
+
+    // Memoize filter results keyed by (image content hash, filter, parameters),
+    // keeping at most max_entries results. Disabled by default.
+    static void enable_cache(std::size_t max_entries = 16);
+    static void disable_cache();
+    static void clear_cache();
 };
 
 #endif // FILTER_H
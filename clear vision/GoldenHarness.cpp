@@ -0,0 +1,377 @@
+#include "GoldenHarness.h"
+#include "Crypto.h"
+#include "Filter.h"
+#include "GrayscaleImage.h"
+#include "SecretImage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+bool file_exists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+// Reset the kernel's peak RSS counter so each case reports its own peak (Linux only)
+void reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+// Peak resident set size in KB: VmHWM on Linux, getrusage elsewhere
+long read_peak_rss_kb() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtol(line.c_str() + 6, nullptr, 10);
+        }
+    }
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;  // Reported in bytes on macOS
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Run setup then op the given number of times; return the fastest op time in seconds
+double fastest_run(int repetitions, const std::function<void()>& setup, const std::function<void()>& op) {
+    double best = 0.0;
+    for (int i = 0; i < std::max(1, repetitions); ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        op();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+// Largest absolute pixel difference, or -1 if the sizes differ
+int max_abs_difference(const GrayscaleImage& a, const GrayscaleImage& b) {
+    if (a.get_width() != b.get_width() || a.get_height() != b.get_height()) {
+        return -1;
+    }
+    int largest = 0;
+    const int* pa = a.begin();
+    const int* pb = b.begin();
+    for (; pa != a.end(); ++pa, ++pb) {
+        largest = std::max(largest, std::abs(*pa - *pb));
+    }
+    return largest;
+}
+
+// Largest absolute difference between two int arrays
+int max_abs_difference(const int* a, const int* b, int count) {
+    int largest = 0;
+    for (int i = 0; i < count; ++i) {
+        largest = std::max(largest, std::abs(a[i] - b[i]));
+    }
+    return largest;
+}
+
+std::string read_text(const std::string& path) {
+    std::ifstream infile(path, std::ios::binary);
+    std::string text((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.pop_back();
+    }
+    return text;
+}
+
+// Collects results while running the cases
+class CaseRunner {
+public:
+    CaseRunner(const GoldenHarness::Options& options, std::vector<GoldenResult>& results)
+        : options(options), results(results) {}
+
+    // Run an image operation on the given inputs and compare its output with
+    // a golden image. For in-place operations the output starts as a copy of
+    // the first input, made outside the timed region.
+    void image_case(const std::string& name, const std::vector<std::string>& inputs, const std::string& golden,
+                    bool in_place, const std::function<void(const std::vector<GrayscaleImage>&, GrayscaleImage&)>& op) {
+        std::vector<std::string> files = inputs;
+        files.push_back(golden);
+        run_case(name, files, [&](GoldenResult& result) {
+            std::vector<GrayscaleImage> images;
+            for (const std::string& input : inputs) {
+                images.emplace_back(path(input).c_str());
+            }
+            GrayscaleImage expected(path(golden).c_str());
+            GrayscaleImage output(images.front());
+
+            result.seconds = fastest_run(options.repetitions,
+                [&]() { if (in_place) output = images.front(); },
+                [&]() { op(images, output); });
+            result.pixels_per_second = pixels_per_second(output, result.seconds);
+
+            result.max_difference = max_abs_difference(output, expected);
+            if (result.max_difference < 0) {
+                result.message = "output size differs from golden";
+            }
+        });
+    }
+
+    // Split an image into triangular arrays and compare them with a golden .dat file
+    void disguise_case(const std::string& name, const std::string& input, const std::string& golden) {
+        run_case(name, {input, golden}, [&](GoldenResult& result) {
+            GrayscaleImage image(path(input).c_str());
+            SecretImage expected = SecretImage::load_from_file(path(golden));
+            std::unique_ptr<SecretImage> secret;
+
+            result.seconds = fastest_run(options.repetitions,
+                [&]() { secret.reset(); },
+                [&]() { secret.reset(new SecretImage(image)); });
+            result.pixels_per_second = pixels_per_second(image, result.seconds);
+
+            int w = secret->get_width();
+            if (w != expected.get_width() || secret->get_height() != expected.get_height()) {
+                result.max_difference = -1;
+                result.message = "output size differs from golden";
+                return;
+            }
+            result.max_difference = std::max(
+                max_abs_difference(secret->get_upper_triangular(), expected.get_upper_triangular(), (w * (w + 1)) / 2),
+                max_abs_difference(secret->get_lower_triangular(), expected.get_lower_triangular(), (w * (w - 1)) / 2));
+        });
+    }
+
+    // Embed a text message into an image and compare with a golden image
+    void embed_case(const std::string& name, const std::string& input, const std::string& message_file,
+                    const std::string& golden) {
+        run_case(name, {input, message_file, golden}, [&](GoldenResult& result) {
+            GrayscaleImage image(path(input).c_str());
+            GrayscaleImage expected(path(golden).c_str());
+            std::string message = read_text(path(message_file));
+            GrayscaleImage output(image);
+            GrayscaleImage revealed(image);
+
+            result.seconds = fastest_run(options.repetitions,
+                [&]() { output = image; },
+                [&]() { revealed = Crypto::embed_LSBits(output, Crypto::encrypt_message(message)).reconstruct(); });
+            result.pixels_per_second = pixels_per_second(image, result.seconds);
+
+            result.max_difference = max_abs_difference(revealed, expected);
+            if (result.max_difference < 0) {
+                result.message = "output size differs from golden";
+            }
+        });
+    }
+
+    // Extract a text message from a golden image and compare with the golden text
+    void extract_case(const std::string& name, const std::string& input, const std::string& message_file) {
+        run_case(name, {input, message_file}, [&](GoldenResult& result) {
+            GrayscaleImage image(path(input).c_str());
+            std::string expected = read_text(path(message_file));
+            SecretImage secret(image);
+            std::string message;
+
+            result.seconds = fastest_run(options.repetitions,
+                []() {},
+                [&]() { message = Crypto::decrypt_message(Crypto::extract_LSBits(secret, static_cast<int>(expected.size()))); });
+            result.pixels_per_second = pixels_per_second(image, result.seconds);
+
+            result.max_difference = message == expected ? 0 : 1;
+            if (message != expected) {
+                result.message = "extracted message differs from golden";
+            }
+        });
+    }
+
+private:
+    std::string path(const std::string& relative) const {
+        return options.sample_dir + "/" + relative;
+    }
+
+    static double pixels_per_second(const GrayscaleImage& image, double seconds) {
+        double pixels = static_cast<double>(image.get_width()) * image.get_height();
+        return seconds > 0.0 ? pixels / seconds : 0.0;
+    }
+
+    // Check the sample files exist, run the body and record its result
+    void run_case(const std::string& name, const std::vector<std::string>& files,
+                  const std::function<void(GoldenResult&)>& body) {
+        GoldenResult result{name, false, 0, 0.0, 0.0, 0, ""};
+
+        for (const std::string& file : files) {
+            if (!file_exists(path(file))) {
+                result.message = "missing sample file " + path(file);
+                results.push_back(result);
+                return;
+            }
+        }
+
+        reset_peak_rss();
+        try {
+            body(result);
+            result.correct = result.max_difference >= 0 && result.max_difference <= options.tolerance;
+            if (!result.correct && result.message.empty()) {
+                std::ostringstream message;
+                message << "max pixel difference " << result.max_difference << " exceeds tolerance "
+                        << options.tolerance;
+                result.message = message.str();
+            }
+        } catch (const std::exception& e) {
+            result.correct = false;
+            result.message = e.what();
+        }
+        result.peak_rss_kb = read_peak_rss_kb();
+        results.push_back(result);
+    }
+
+    const GoldenHarness::Options& options;
+    std::vector<GoldenResult>& results;
+};
+
+// Baseline entry: name seconds pixels_per_second peak_rss_kb
+std::map<std::string, GoldenResult> read_baseline(const std::string& filename) {
+    std::map<std::string, GoldenResult> baseline;
+    std::ifstream infile(filename);
+    std::string line;
+    while (std::getline(infile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        GoldenResult entry{"", true, 0, 0.0, 0.0, 0, ""};
+        if (fields >> entry.name >> entry.seconds >> entry.pixels_per_second >> entry.peak_rss_kb) {
+            baseline[entry.name] = entry;
+        }
+    }
+    return baseline;
+}
+
+void write_baseline(const std::string& filename, const std::vector<GoldenResult>& results) {
+    std::ofstream outfile(filename);
+    if (!outfile.is_open()) {
+        throw std::runtime_error("Error opening file: " + filename);
+    }
+    outfile << "# name seconds pixels_per_second peak_rss_kb\n";
+    for (const GoldenResult& result : results) {
+        outfile << result.name << " " << result.seconds << " " << result.pixels_per_second << " "
+                << result.peak_rss_kb << "\n";
+    }
+}
+
+} // namespace
+
+// Run every golden case found under the sample directory
+std::vector<GoldenResult> GoldenHarness::run_cases(const Options& options) {
+    std::vector<GoldenResult> results;
+    CaseRunner runner(options, results);
+
+    for (int k : {3, 11, 19}) {
+        std::string size = std::to_string(k) + "x" + std::to_string(k);
+        runner.image_case("mean_" + size, {"mean/creep.jpg"}, "mean/mean_filtered_creep_" + size + ".png", true,
+            [k](const std::vector<GrayscaleImage>&, GrayscaleImage& image) { Filter::apply_mean_filter(image, k); });
+    }
+
+    for (int k : {21, 41}) {
+        for (int sigma : {2, 4}) {
+            std::string suffix = std::to_string(k) + "x" + std::to_string(k) + "_" + std::to_string(sigma);
+            runner.image_case("gauss_" + suffix, {"gauss/puppy.png"}, "gauss/gaussian_filtered_puppy_" + suffix + ".png", true,
+                [k, sigma](const std::vector<GrayscaleImage>&, GrayscaleImage& image) {
+                    Filter::apply_gaussian_smoothing(image, k, sigma);
+                });
+        }
+    }
+
+    for (int amount : {1, 5, 10}) {
+        std::string suffix = "9x9_" + std::to_string(amount);
+        runner.image_case("unsharp_" + suffix, {"unsharp/flowers.png"}, "unsharp/unsharp_filtered_flowers_" + suffix + ".png", true,
+            [amount](const std::vector<GrayscaleImage>&, GrayscaleImage& image) {
+                Filter::apply_unsharp_mask(image, 9, amount);
+            });
+    }
+
+    runner.image_case("addition", {"addition/image1.png", "addition/image2.png"}, "addition/added_image1_image2.png", false,
+        [](const std::vector<GrayscaleImage>& inputs, GrayscaleImage& output) { output = inputs[0] + inputs[1]; });
+    runner.image_case("subtraction", {"subtraction/image1.png", "subtraction/image2.png"},
+        "subtraction/subtracted_image1_image2.png", false,
+        [](const std::vector<GrayscaleImage>& inputs, GrayscaleImage& output) { output = inputs[0] - inputs[1]; });
+
+    runner.disguise_case("disguise", "disguise-reveal/flowers.png", "disguise-reveal/secret_image_flowers.dat");
+    runner.image_case("reveal", {"disguise-reveal/flowers.png"}, "disguise-reveal/flowers.png", false,
+        [&options](const std::vector<GrayscaleImage>&, GrayscaleImage& output) {
+            output = SecretImage::load_from_file(options.sample_dir + "/disguise-reveal/secret_image_flowers.dat").reconstruct();
+        });
+
+    runner.embed_case("embed_message", "secret message encrpytion/puppy.png", "secret message encrpytion/secret_message.txt",
+        "secret message encrpytion/puppy_with_secret_message_embedded.png");
+    runner.extract_case("extract_message", "secret message encrpytion/puppy_with_secret_message_embedded.png",
+        "secret message encrpytion/secret_message.txt");
+
+    return results;
+}
+
+// Run the cases, then record the baseline or check for regressions against it
+bool GoldenHarness::run(const Options& options, std::ostream& out) {
+    std::vector<GoldenResult> results = run_cases(options);
+    std::map<std::string, GoldenResult> baseline;
+    if (!options.record) {
+        baseline = read_baseline(options.baseline_file);
+        if (baseline.empty()) {
+            out << "No baseline in " << options.baseline_file << "; timings are not compared.\n";
+        }
+    }
+
+    bool passed = true;
+    out << std::left << std::setw(20) << "case" << std::right << std::setw(12) << "seconds" << std::setw(14)
+        << "Mpixels/s" << std::setw(12) << "peak KB" << std::setw(10) << "baseline" << "  status\n";
+    for (const GoldenResult& result : results) {
+        std::string status = result.correct ? "ok" : "WRONG: " + result.message;
+        std::ostringstream change;
+
+        auto entry = baseline.find(result.name);
+        if (entry != baseline.end() && entry->second.seconds > 0.0) {
+            double ratio = result.seconds / entry->second.seconds - 1.0;
+            change << std::showpos << std::fixed << std::setprecision(0) << ratio * 100.0 << "%";
+            double slowdown = result.seconds - entry->second.seconds;
+            if (result.correct && ratio > options.slowdown_threshold && slowdown > options.noise_floor) {
+                status = "SLOWER than baseline";
+                passed = false;
+            }
+        }
+        if (!result.correct) {
+            passed = false;
+        }
+
+        out << std::left << std::setw(20) << result.name << std::right << std::fixed << std::setprecision(4)
+            << std::setw(12) << result.seconds << std::setprecision(2) << std::setw(14)
+            << result.pixels_per_second / 1e6 << std::setw(12) << result.peak_rss_kb << std::setw(10)
+            << change.str() << "  " << status << "\n";
+    }
+
+    // Timings of wrong outputs are no reference, so a failing run records nothing
+    if (options.record && passed) {
+        write_baseline(options.baseline_file, results);
+        out << "Baseline written to " << options.baseline_file << "\n";
+    } else if (options.record) {
+        out << "Baseline NOT written: some outputs are wrong\n";
+    }
+    return passed;
+}
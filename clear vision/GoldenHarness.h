@@ -0,0 +1,41 @@
+#ifndef GOLDEN_HARNESS_H
+#define GOLDEN_HARNESS_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Outcome of one golden case
+struct GoldenResult {
+    std::string name;
+    bool correct;            // Output matched the golden within tolerance
+    int max_difference;      // Largest absolute pixel difference (1 for non-image mismatches)
+    double seconds;          // Fastest of the timed repetitions
+    double pixels_per_second;
+    long peak_rss_kb;        // Peak resident set size while running the case
+    std::string message;     // Reason for a failure, if any
+};
+
+// Runs every operation against the inputs and expected outputs in sample_io/,
+// checks the results, and compares wall time against a recorded baseline.
+class GoldenHarness {
+public:
+    struct Options {
+        std::string sample_dir = "sample_io";
+        std::string baseline_file = "golden_baseline.txt";
+        double slowdown_threshold = 0.25;  // Fail when slower than baseline by this fraction...
+        double noise_floor = 0.001;        // ...and by more than this many seconds
+        int tolerance = 0;                 // Allowed absolute pixel difference
+        int repetitions = 3;               // Timed runs per case; the fastest counts
+        bool record = false;               // Write a new baseline (only if all outputs are correct) instead of comparing
+    };
+
+    // Run all cases without consulting the baseline
+    static std::vector<GoldenResult> run_cases(const Options& options);
+
+    // Run all cases, record or compare the baseline and print a report.
+    // Returns true when every case is correct and none regressed.
+    static bool run(const Options& options, std::ostream& out);
+};
+
+#endif // GOLDEN_HARNESS_H
@@ -1,4 +1,6 @@
 #include "GrayscaleImage.h"
+#include "MemoryTracker.h"
+#include "AsyncIO.h"
 #include <iostream>
 #include <cstring>  // For memcpy
 #define STB_IMAGE_IMPLEMENTATION
@@ -6,14 +8,77 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 #include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <utility>
 
+namespace {
+
+// Pixels converted to the 8-bit buffer stb_image_write expects
+class EncodedImage {
+public:
+    explicit EncodedImage(const GrayscaleImage& image)
+        : width(image.get_width()), height(image.get_height()),
+          reservation(static_cast<size_t>(width) * height), bytes(static_cast<size_t>(width) * height) {
+        // Convert int to unsigned char
+        std::copy(image.begin(), image.end(), bytes.begin());
+    }
+
+    // Write the buffer to a PNG file; returns false on failure
+    bool write_png(const char* filename) const {
+        return stbi_write_png(filename, width, height, 1, bytes.data(), width) != 0;
+    }
+
+private:
+    int width, height;
+    MemoryReservation reservation;
+    std::vector<unsigned char> bytes;
+};
+
+} // namespace
+
+
+// Allocate one contiguous block for the pixels plus a table of row pointers into it
+void GrayscaleImage::allocate(int w, int h) {
+    // Throws MemoryBudgetExceeded before anything is allocated
+    MemoryTracker::acquire(storage_bytes(w, h), MemoryTracker::IMAGE_PIXELS);
+    int* pixels = nullptr;
+    try {
+        pixels = new int[static_cast<size_t>(w) * h];
+        data = new int*[h];
+    } catch (...) {
+        delete[] pixels;
+        MemoryTracker::release(storage_bytes(w, h), MemoryTracker::IMAGE_PIXELS);
+        throw;
+    }
+    pixel_buffer = pixels;
+    width = w;
+    height = h;
+    for (int i = 0; i < height; ++i) {
+        data[i] = pixel_buffer + static_cast<size_t>(i) * width;
+    }
+}
+
+// Free the pixel block and the row table, leaving an empty image
+void GrayscaleImage::release() {
+    if (pixel_buffer != nullptr) {
+        MemoryTracker::release(storage_bytes(width, height), MemoryTracker::IMAGE_PIXELS);
+    }
+    delete[] data;
+    delete[] pixel_buffer;
+    data = nullptr;
+    pixel_buffer = nullptr;
+    width = 0;
+    height = 0;
+}
 
 // Constructor: load from a file
 GrayscaleImage::GrayscaleImage(const char* filename) {
 
     // Image loading code using stbi
     int channels;
-    unsigned char* image = stbi_load(filename, &width, &height, &channels, STBI_grey);
+    int w, h;
+    unsigned char* image = stbi_load(filename, &w, &h, &channels, STBI_grey);
 
     if (image == nullptr) {
         std::cerr << "Error: Could not load image " << filename << std::endl;
@@ -21,16 +86,15 @@ GrayscaleImage::GrayscaleImage(const char* filename) {
     }
 
     // Dynamically allocate memory for a 2D matrix based on the given dimensions.
-    data = new int*[height];
-    for (int i = 0; i < height; ++i) {
-        data[i] = new int[width];
+    try {
+        allocate(w, h);
+    } catch (...) {
+        stbi_image_free(image);
+        throw;
     }
+
     // Fill the matrix with pixel values from the image
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            data[i][j] = static_cast<int>(image[i * width + j]);
-        }
-    }
+    std::copy(image, image + static_cast<size_t>(width) * height, pixel_buffer);
 
     // Free the dynamically allocated memory of stbi image
     stbi_image_free(image);
@@ -39,73 +103,85 @@ GrayscaleImage::GrayscaleImage(const char* filename) {
 GrayscaleImage& GrayscaleImage::operator=(const GrayscaleImage& other) {
     if (this == &other) return *this; // Self-assignment check
 
-    // Free existing memory
-    for (int i = 0; i < height; ++i) {
-        delete[] data[i];
+    // Reuse the existing memory when the dimensions match. Otherwise copy
+    // into new memory first and take it over, so that this image is left
+    // unchanged if the copy does not fit in the memory budget.
+    if (width != other.width || height != other.height) {
+        GrayscaleImage copy(other);
+        return *this = std::move(copy);
     }
-    delete[] data;
+    std::copy(other.begin(), other.end(), pixel_buffer);
 
-    // Reallocate memory according to new dimensions
-    width = other.width;
-    height = other.height;
-    data = new int*[height];
-    for (int i = 0; i < height; ++i) {
-        data[i] = new int[width];
-        // Copy the data
-        for (int j = 0; j < width; ++j) {
-            data[i][j] = other.data[i][j];
-        }
-    }
+    // The copied pixels keep the source's hashes
+    tile_hashes = other.tile_hashes;
+    tile_valid = other.tile_valid;
+    any_tile_hash_valid = other.any_tile_hash_valid;
 
     return *this;
 }
 // Constructor: initialize from a pre-existing data matrix
-GrayscaleImage::GrayscaleImage(int** inputData, int h, int w) : width(w), height(h) {
+GrayscaleImage::GrayscaleImage(int** inputData, int h, int w) {
     // Initialize the image with a pre-existing data matrix by copying the values.
-    // Don't forget to dynamically allocate memory for the matrix.
-    data = new int*[height];
+    allocate(w, h);
     for (int i = 0; i < height; ++i) {
-        data[i] = new int[width];
-        for (int j = 0; j < width; ++j) {
-            data[i][j] = inputData[i][j];
-        }
+        std::copy(inputData[i], inputData[i] + width, data[i]);
     }
 }
 
 // Constructor to create a blank image of given width and height
-GrayscaleImage::GrayscaleImage(int w, int h) : width(w), height(h) {
-    // Just dynamically allocate the memory for the new matrix.
-    data = new int*[height];
-    for (int i = 0; i < height; ++i) {
-        data[i] = new int[width];
-        // Initialize all pixels to 0 (black)
-        for (int j = 0; j < width; ++j) {
-            data[i][j] = 0;
-        }
-    }
+GrayscaleImage::GrayscaleImage(int w, int h) {
+    // Allocate the matrix and initialize all pixels to 0 (black)
+    allocate(w, h);
+    std::fill(begin(), end(), 0);
 }
 
 // Copy constructor
-GrayscaleImage::GrayscaleImage(const GrayscaleImage& other) : width(other.width), height(other.height) {
+GrayscaleImage::GrayscaleImage(const GrayscaleImage& other)
+    : tile_hashes(other.tile_hashes), tile_valid(other.tile_valid),
+      any_tile_hash_valid(other.any_tile_hash_valid) {
 
-    // Copy constructor: dynamically allocate memory and
-    // copy pixel values from another image.
-    data = new int*[height];
-    for (int i = 0; i < height; ++i) {
-        data[i] = new int[width];
-        for (int j = 0; j < width; ++j) {
-            data[i][j] = other.data[i][j];
-        }
-    }
+    // Copy constructor: allocate memory and copy pixel values from another image.
+    allocate(other.width, other.height);
+    std::copy(other.begin(), other.end(), pixel_buffer);
+}
+
+// Move constructor
+GrayscaleImage::GrayscaleImage(GrayscaleImage&& other) noexcept
+    : data(other.data), pixel_buffer(other.pixel_buffer), width(other.width), height(other.height),
+      tile_hashes(std::move(other.tile_hashes)), tile_valid(std::move(other.tile_valid)),
+      any_tile_hash_valid(other.any_tile_hash_valid) {
+    other.data = nullptr;
+    other.pixel_buffer = nullptr;
+    other.width = 0;
+    other.height = 0;
+    other.any_tile_hash_valid = false;
+}
+
+// Move assignment operator
+GrayscaleImage& GrayscaleImage::operator=(GrayscaleImage&& other) noexcept {
+    if (this == &other) return *this; // Self-assignment check
+
+    release();
+    data = other.data;
+    pixel_buffer = other.pixel_buffer;
+    width = other.width;
+    height = other.height;
+    tile_hashes = std::move(other.tile_hashes);
+    tile_valid = std::move(other.tile_valid);
+    any_tile_hash_valid = other.any_tile_hash_valid;
+
+    other.data = nullptr;
+    other.pixel_buffer = nullptr;
+    other.width = 0;
+    other.height = 0;
+    other.any_tile_hash_valid = false;
+    return *this;
 }
 
 // Destructor
 GrayscaleImage::~GrayscaleImage() {
     // Deallocate memory for the matrix
-    for (int i = 0; i < height; ++i) {
-        delete[] data[i];
-    };
-    delete[] data;
+    release();
 }
 
 
@@ -116,8 +192,36 @@ bool GrayscaleImage::operator==(const GrayscaleImage& other) const {
     if (width != other.width || height != other.height) {
         return false;
     }
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
+
+    // Without cached hashes on both sides, a single pass over the pixels is cheapest
+    if (!any_tile_hash_valid || !other.any_tile_hash_valid) {
+        return std::equal(begin(), end(), other.begin());
+    }
+
+    // Compare tile by tile: where both tiles already have hashes, a mismatch
+    // proves the tiles differ. Everything else is compared pixel by pixel;
+    // no new hashes are computed.
+    for (int tr = 0; tr < get_tile_rows(); ++tr) {
+        for (int tc = 0; tc < get_tile_cols(); ++tc) {
+            int index = tr * get_tile_cols() + tc;
+            if (tile_hash_cached(index) && other.tile_hash_cached(index) &&
+                tile_hashes[index] != other.tile_hashes[index]) {
+                return false;
+            }
+            if (!tile_equals(other, tr, tc)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Compare the pixels of one tile against the same tile of another image
+bool GrayscaleImage::tile_equals(const GrayscaleImage& other, int tile_row, int tile_col) const {
+    int row_end = std::min((tile_row + 1) * TILE_SIZE, height);
+    int col_end = std::min((tile_col + 1) * TILE_SIZE, width);
+    for (int i = tile_row * TILE_SIZE; i < row_end; ++i) {
+        for (int j = tile_col * TILE_SIZE; j < col_end; ++j) {
             if (data[i][j] != other.data[i][j]) {
                 return false;
             }
@@ -126,49 +230,88 @@ bool GrayscaleImage::operator==(const GrayscaleImage& other) const {
     return true;
 }
 
+// Hash of one tile, computed with FNV-1a over its pixels and cached until the tile is written
+std::uint64_t GrayscaleImage::tile_hash(int tile_row, int tile_col) const {
+    if (tile_row < 0 || tile_row >= get_tile_rows() || tile_col < 0 || tile_col >= get_tile_cols()) {
+        throw std::out_of_range("Tile coordinates are out of image bounds.");
+    }
 
-/// Addition operator
-GrayscaleImage GrayscaleImage::operator+(const GrayscaleImage& other) const {
-    // Create a new image for the result
-    GrayscaleImage result(width, height);
+    size_t num_tiles = static_cast<size_t>(get_tile_rows()) * get_tile_cols();
+    if (tile_valid.size() != num_tiles) {
+        tile_hashes.assign(num_tiles, 0);
+        tile_valid.assign(num_tiles, 0);
+    }
 
-    // Add two images' pixel values and return a new image, clamping the results.
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int sum = data[i][j] + other.data[i][j];
-            // Ensure the value stays within [0, 255]
-            if (sum < 0) {
-                sum = 0;
-            } else if (sum > 255) {
-                sum = 255;
-            }
-            result.data[i][j] = sum;
+    int index = tile_row * get_tile_cols() + tile_col;
+    if (tile_valid[index]) {
+        return tile_hashes[index];
+    }
+
+    std::uint64_t hash = 14695981039346656037ULL;
+    int row_end = std::min((tile_row + 1) * TILE_SIZE, height);
+    int col_end = std::min((tile_col + 1) * TILE_SIZE, width);
+    for (int i = tile_row * TILE_SIZE; i < row_end; ++i) {
+        for (int j = tile_col * TILE_SIZE; j < col_end; ++j) {
+            hash ^= static_cast<std::uint32_t>(data[i][j]);
+            hash *= 1099511628211ULL;
         }
     }
 
-    return result;
+    tile_hashes[index] = hash;
+    tile_valid[index] = 1;
+    any_tile_hash_valid = true;
+    return hash;
+}
+
+// Hash of the whole image, combining the dimensions with every tile hash
+std::uint64_t GrayscaleImage::content_hash() const {
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](std::uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+
+    mix(static_cast<std::uint64_t>(width));
+    mix(static_cast<std::uint64_t>(height));
+    for (int tr = 0; tr < get_tile_rows(); ++tr) {
+        for (int tc = 0; tc < get_tile_cols(); ++tc) {
+            mix(tile_hash(tr, tc));
+        }
+    }
+    return hash;
 }
 
-// Subtraction operator
-GrayscaleImage GrayscaleImage::operator-(const GrayscaleImage& other) const {
-    // Create a new image for the result
-    GrayscaleImage result(width, height);
+// List the tiles that differ between two images of the same size
+std::vector<ImageTile> GrayscaleImage::diff_tiles(const GrayscaleImage& other) const {
+    if (width != other.width || height != other.height) {
+        throw std::invalid_argument("Images must have the same dimensions to be diffed.");
+    }
 
-    // Subtract pixel values of two images and return a new image, clamping the results.
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            int difference = data[i][j] - other.data[i][j];
-            // Ensure the value stays within [0, 255]
-            if (difference < 0) {
-                difference = 0;
-            } else if (difference > 255) {
-                difference = 255;
+    std::vector<ImageTile> differing;
+    for (int tr = 0; tr < get_tile_rows(); ++tr) {
+        for (int tc = 0; tc < get_tile_cols(); ++tc) {
+            if (tile_hash(tr, tc) == other.tile_hash(tr, tc) && tile_equals(other, tr, tc)) {
+                continue;
             }
-            result.data[i][j] = difference;
+            int row = tr * TILE_SIZE;
+            int col = tc * TILE_SIZE;
+            differing.push_back({row, col, std::min(TILE_SIZE, height - row), std::min(TILE_SIZE, width - col)});
         }
     }
+    return differing;
+}
 
-    return result;
+// Forget the cached hashes of one row of tiles
+void GrayscaleImage::invalidate_tile_row(int tile_row) {
+    int tile_cols = get_tile_cols();
+    std::fill(tile_valid.begin() + tile_row * tile_cols, tile_valid.begin() + (tile_row + 1) * tile_cols, 0);
+}
+
+// Forget every cached tile hash
+void GrayscaleImage::invalidate_hashes() const {
+    if (any_tile_hash_valid) {
+        std::fill(tile_valid.begin(), tile_valid.end(), 0);
+        any_tile_hash_valid = false;
+    }
 }
 
 
@@ -186,6 +329,10 @@ void GrayscaleImage::set_pixel(int row, int col, int value) {
     if(row < 0 || row >= height || col < 0 || col >= width) {
         throw std::out_of_range("Pixel coordinates are out of image bounds.");
     }
+    // The tile holding this pixel has to be rehashed
+    if (any_tile_hash_valid) {
+        tile_valid[tile_index(row, col)] = 0;
+    }
     // Ensure the value stays within [0, 255]
     if (value < 0) {
         data[row][col] = 0;
@@ -199,21 +346,42 @@ void GrayscaleImage::set_pixel(int row, int col, int value) {
 
 // Function to save the image to a PNG file
 void GrayscaleImage::save_to_file(const char* filename) const {
-    // Create a buffer to hold the image data in the format stb_image_write expects
-    unsigned char* imageBuffer = new unsigned char[width * height];
-
-    // Fill the buffer with pixel data (convert int to unsigned char)
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            imageBuffer[i * width + j] = static_cast<unsigned char>(data[i][j]);
-        }
-    }
+    // Create a buffer holding the image data in the format stb_image_write expects
+    EncodedImage encoded(*this);
 
     // Write the buffer to a PNG file
-    if (!stbi_write_png(filename, width, height, 1, imageBuffer, width)) {
+    if (!encoded.write_png(filename)) {
         std::cerr << "Error: Could not save image to file " << filename << std::endl;
     }
+}
+
+// Save to a PNG file on the I/O thread pool. Only the conversion to 8-bit
+// pixels happens on the calling thread; compression and writing do not.
+std::future<void> GrayscaleImage::save_to_file_async(const std::string& filename) const {
+    auto encoded = std::make_shared<const EncodedImage>(*this);
+    return AsyncIO::submit([encoded, filename]() mutable {
+        bool written = encoded->write_png(filename.c_str());
+        encoded.reset();  // Free the buffer before the future becomes ready
+        if (!written) {
+            throw std::runtime_error("Could not save image to file " + filename);
+        }
+    });
+}
+
+// Load an image on the I/O thread pool. Unlike the file constructor, a
+// missing or unreadable file is reported through the future.
+std::future<GrayscaleImage> GrayscaleImage::load_from_file_async(const std::string& filename) {
+    return AsyncIO::submit([filename]() {
+        int channels;
+        int w, h;
+        std::unique_ptr<unsigned char, void (*)(void*)> image(
+            stbi_load(filename.c_str(), &w, &h, &channels, STBI_grey), stbi_image_free);
+        if (image == nullptr) {
+            throw std::runtime_error("Could not load image " + filename);
+        }
 
-    // Clean up the allocated buffer
-    delete[] imageBuffer;
+        GrayscaleImage result(w, h);
+        std::copy(image.get(), image.get() + static_cast<size_t>(w) * h, result.pixels());
+        return result;
+    });
 }
@@ -1,13 +1,90 @@
 #ifndef GRAYSCALE_IMAGE_H
 #define GRAYSCALE_IMAGE_H
 
-class GrayscaleImage {
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+#include "ImageExpression.h"
+
+// A rectangular block of pixels, used to report differing tiles
+struct ImageTile {
+    int row, col;       // Top-left pixel of the tile
+    int height, width;  // Size of the tile (edge tiles may be smaller)
+};
+
+// A contiguous run of pixels, e.g. one image row
+template <typename T>
+class PixelSpan {
+public:
+    PixelSpan(T* first, int size) : first(first), count(size) {}
+
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+    T& operator[](int i) const { return first[i]; }
+    int size() const { return count; }
+
+private:
+    T* first;
+    int count;
+};
+
+// Range over the rows of an image, yielding one PixelSpan per row
+template <typename T>
+class RowRange {
+public:
+    class iterator {
+    public:
+        iterator(T* row, int width) : row(row), width(width) {}
+        PixelSpan<T> operator*() const { return PixelSpan<T>(row, width); }
+        iterator& operator++() { row += width; return *this; }
+        bool operator!=(const iterator& other) const { return row != other.row; }
+
+    private:
+        T* row;
+        int width;
+    };
+
+    RowRange(T* first, int width, int height) : first(first), width(width), height(height) {}
+
+    iterator begin() const { return iterator(first, width); }
+    iterator end() const { return iterator(first + static_cast<long long>(width) * height, width); }
+
 private:
-    int** data;
+    T* first;
     int width, height;
+};
+
+class GrayscaleImage {
+private:
+    int** data = nullptr;         // Row pointers into pixel_buffer
+    int* pixel_buffer = nullptr;  // All pixels, row-major and contiguous
+    int width = 0, height = 0;
+
+    // Allocate storage for a w x h image (pixels left uninitialized),
+    // counted against the MemoryTracker budget
+    void allocate(int w, int h);
+    void release();
+
+    // Per-tile content hashes, computed lazily and invalidated on write
+    mutable std::vector<std::uint64_t> tile_hashes;
+    mutable std::vector<char> tile_valid;
+    mutable bool any_tile_hash_valid = false;
 
+    int tile_index(int row, int col) const {
+        return (row / TILE_SIZE) * get_tile_cols() + col / TILE_SIZE;
+    }
+    bool tile_equals(const GrayscaleImage& other, int tile_row, int tile_col) const;
+    bool tile_hash_cached(int index) const {
+        return static_cast<size_t>(index) < tile_valid.size() && tile_valid[index];
+    }
+    void invalidate_tile_row(int tile_row);
 
 public:
+    // Side length of the square tiles used for content hashing
+    static constexpr int TILE_SIZE = 64;
+
     // Constructor: loads an image from a file
     GrayscaleImage(const char* filename);
 
@@ -20,15 +97,30 @@ public:
     // Copy constructor
     GrayscaleImage(const GrayscaleImage& other);
 
+    // Move constructor: takes over the pixels, leaving other empty
+    GrayscaleImage(GrayscaleImage&& other) noexcept;
+
+    // Constructor: evaluates an arithmetic expression such as a + b - c
+    template <typename Op, typename L, typename R>
+    GrayscaleImage(const ImageArithmetic<Op, L, R>& expression);
+
     // Destructor
     ~GrayscaleImage();
     GrayscaleImage& operator=(const GrayscaleImage& other);
+    GrayscaleImage& operator=(GrayscaleImage&& other) noexcept;
+
+    // Assign the result of an arithmetic expression in a single pass
+    template <typename Op, typename L, typename R>
+    GrayscaleImage& operator=(const ImageArithmetic<Op, L, R>& expression);
 
 
-    // Operator overloads
+    // Operator overloads (+ and - build lazy expressions, see ImageExpression.h)
     bool operator==(const GrayscaleImage& other) const;
-    GrayscaleImage operator+(const GrayscaleImage& other) const;
-    GrayscaleImage operator-(const GrayscaleImage& other) const;
+
+    // Bytes of pixel storage a w x h image holds
+    static std::size_t storage_bytes(int w, int h) {
+        return (static_cast<std::size_t>(w) * h) * sizeof(int) + static_cast<std::size_t>(h) * sizeof(int*);
+    }
 
     // Method to get image dimensions
     int get_width() const { return width; }
@@ -40,13 +132,106 @@ public:
     // Set a specific pixel value
     void set_pixel(int row, int col, int value);
 
+    // Fast, unchecked access for hot loops. Rows are stride() ints apart in
+    // one contiguous block, and values written here are not clamped.
+    // Non-const access invalidates the affected tile hashes.
+    int stride() const { return width; }
+    int* row(int r) {
+        if (any_tile_hash_valid) {
+            invalidate_tile_row(r / TILE_SIZE);
+        }
+        return data[r];
+    }
+    const int* row(int r) const { return data[r]; }
+    int* pixels() {
+        invalidate_hashes();
+        return pixel_buffer;
+    }
+    const int* pixels() const { return pixel_buffer; }
+
+    // Range-based iteration over all pixels in row-major order
+    int* begin() { return pixels(); }
+    int* end() { return pixel_buffer + static_cast<long long>(width) * height; }
+    const int* begin() const { return pixel_buffer; }
+    const int* end() const { return pixel_buffer + static_cast<long long>(width) * height; }
+
+    // Range-based iteration over rows
+    RowRange<int> rows() { return RowRange<int>(pixels(), width, height); }
+    RowRange<const int> rows() const { return RowRange<const int>(pixel_buffer, width, height); }
+
+    // Number of hash tiles along each axis
+    int get_tile_rows() const { return (height + TILE_SIZE - 1) / TILE_SIZE; }
+    int get_tile_cols() const { return (width + TILE_SIZE - 1) / TILE_SIZE; }
+
+    // Content hash of a single tile, computed on first use
+    std::uint64_t tile_hash(int tile_row, int tile_col) const;
+
+    // Content hash of the whole image (dimensions and all tiles)
+    std::uint64_t content_hash() const;
+
+    // Tiles whose pixels differ from another image of the same size
+    std::vector<ImageTile> diff_tiles(const GrayscaleImage& other) const;
+
+    // Drop cached hashes; call after writing pixels through get_data()
+    void invalidate_hashes() const;
+
     // Function to write the image data back to a PNG file
     void save_to_file(const char* filename) const;
 
-    // Getter function for data.
+    // Asynchronous save and load on the AsyncIO thread pool. The pixels are
+    // copied before save_to_file_async returns, so the image can be changed
+    // or destroyed while the file is written. Failures are reported as
+    // std::runtime_error from the future's get().
+    std::future<void> save_to_file_async(const std::string& filename) const;
+    static std::future<GrayscaleImage> load_from_file_async(const std::string& filename);
+
+    // Getter function for data. Cached hashes are dropped, as the caller may
+    // write through the returned pointer; writes made after a later hash
+    // (e.g. operator== or a memoized filter) need another invalidate_hashes().
     int** get_data() const {
+        invalidate_hashes();
         return data;
     }
+
+private:
+    // Write an expression of the same size into this image, one row at a time
+    template <typename Expression>
+    void evaluate(const Expression& expression);
 };
 
+template <typename Op, typename L, typename R>
+GrayscaleImage::GrayscaleImage(const ImageArithmetic<Op, L, R>& expression) {
+    allocate(expression.get_width(), expression.get_height());
+    evaluate(expression);
+}
+
+template <typename Op, typename L, typename R>
+GrayscaleImage& GrayscaleImage::operator=(const ImageArithmetic<Op, L, R>& expression) {
+    // Pixels only depend on the operands at the same position, so an image
+    // of the right size can be overwritten in place even if it is an operand.
+    // Otherwise evaluate into a new image, as the expression may still read
+    // from a view of this one.
+    if (width == expression.get_width() && height == expression.get_height()) {
+        invalidate_hashes();
+        evaluate(expression);
+    } else {
+        *this = GrayscaleImage(expression);
+    }
+    return *this;
+}
+
+template <typename Expression>
+void GrayscaleImage::evaluate(const Expression& expression) {
+    // Work on locals so that the stores below cannot alias the loop bounds
+    int rows = height;
+    int cols = width;
+    for (int r = 0; r < rows; ++r) {
+        auto source = expression.row(r);
+        int* out = data[r];
+        for (int c = 0; c < cols; ++c) {
+            out[c] = source[c];
+        }
+    }
+}
+
 #endif // GRAYSCALE_IMAGE_H
@@ -0,0 +1,93 @@
+#ifndef IMAGE_EXPRESSION_H
+#define IMAGE_EXPRESSION_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+class GrayscaleImage;
+class ImageView;
+
+// Saturating pixel operations used by the arithmetic operators
+struct SaturatingAdd {
+    static int apply(int a, int b) { return std::min(std::max(a + b, 0), 255); }
+};
+
+struct SaturatingSubtract {
+    static int apply(int a, int b) { return std::min(std::max(a - b, 0), 255); }
+};
+
+template <typename Op, typename L, typename R>
+class ImageArithmetic;
+
+// Types that may appear as operands of image arithmetic
+template <typename T>
+struct is_image_operand : std::false_type {};
+template <>
+struct is_image_operand<GrayscaleImage> : std::true_type {};
+template <>
+struct is_image_operand<ImageView> : std::true_type {};
+template <typename Op, typename L, typename R>
+struct is_image_operand<ImageArithmetic<Op, L, R>> : std::true_type {};
+
+// Images are held by reference; views and sub-expressions are small and
+// held by value
+template <typename T>
+struct operand_storage {
+    using type = T;
+};
+template <>
+struct operand_storage<GrayscaleImage> {
+    using type = const GrayscaleImage&;
+};
+
+// A lazily evaluated, saturating pixel-wise operation on two operands.
+// Nothing is computed until the expression is assigned to a GrayscaleImage,
+// which then evaluates the whole chain in a single pass, clamping after
+// every step exactly as the eager operators did. Image operands are held by
+// reference, so evaluate an expression in the statement that builds it.
+template <typename Op, typename L, typename R>
+class ImageArithmetic {
+public:
+    // The operation applied to one row of both operands
+    template <typename LRow, typename RRow>
+    struct Row {
+        LRow lhs;
+        RRow rhs;
+        int operator[](int col) const { return Op::apply(lhs[col], rhs[col]); }
+    };
+
+    ImageArithmetic(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {
+        if (lhs.get_width() != rhs.get_width() || lhs.get_height() != rhs.get_height()) {
+            throw std::invalid_argument("Images must have the same dimensions.");
+        }
+    }
+
+    int get_width() const { return lhs.get_width(); }
+    int get_height() const { return lhs.get_height(); }
+
+    auto row(int r) const -> Row<decltype(std::declval<const L&>().row(r)), decltype(std::declval<const R&>().row(r))> {
+        return {lhs.row(r), rhs.row(r)};
+    }
+
+private:
+    typename operand_storage<L>::type lhs;
+    typename operand_storage<R>::type rhs;
+};
+
+// Addition operator: saturating pixel-wise sum of two images, views or expressions
+template <typename L, typename R,
+          typename = typename std::enable_if<is_image_operand<L>::value && is_image_operand<R>::value>::type>
+ImageArithmetic<SaturatingAdd, L, R> operator+(const L& lhs, const R& rhs) {
+    return ImageArithmetic<SaturatingAdd, L, R>(lhs, rhs);
+}
+
+// Subtraction operator: saturating pixel-wise difference of two images, views or expressions
+template <typename L, typename R,
+          typename = typename std::enable_if<is_image_operand<L>::value && is_image_operand<R>::value>::type>
+ImageArithmetic<SaturatingSubtract, L, R> operator-(const L& lhs, const R& rhs) {
+    return ImageArithmetic<SaturatingSubtract, L, R>(lhs, rhs);
+}
+
+#endif // IMAGE_EXPRESSION_H
@@ -0,0 +1,276 @@
+#include "ImagePyramid.h"
+#include "Filter.h"
+#include "ImageView.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Smallest sigma, in coarse pixels, left for the blur on a coarse level.
+// Coarser levels than that alias visibly when upsampled.
+const double MIN_COARSE_SIGMA = 1.0;
+
+// Blur with the separable [1 4 6 4 1]/16 kernel and keep every second
+// pixel. Out-of-bounds pixels count as black.
+GrayscaleImage decimate(const GrayscaleImage& source) {
+    static const int WEIGHTS[5] = {1, 4, 6, 4, 1};
+    int width = source.get_width();
+    int height = source.get_height();
+    GrayscaleImage result((width + 1) / 2, (height + 1) / 2);
+
+    MemoryReservation scratch(width * sizeof(int));
+    std::vector<int> column_sums(width);
+    for (int y = 0; y < result.get_height(); ++y) {
+        // Vertical pass over the five source rows around 2y
+        std::fill(column_sums.begin(), column_sums.end(), 0);
+        for (int k = -2; k <= 2; ++k) {
+            int sourceY = 2 * y + k;
+            if (sourceY < 0 || sourceY >= height) {
+                continue;
+            }
+            const int* sourceRow = source.row(sourceY);
+            int weight = WEIGHTS[k + 2];
+            for (int x = 0; x < width; ++x) {
+                column_sums[x] += weight * sourceRow[x];
+            }
+        }
+
+        // Horizontal pass at every second column, rounded to nearest
+        int* outRow = result.row(y);
+        for (int x = 0; x < result.get_width(); ++x) {
+            int sum = 0;
+            for (int k = -2; k <= 2; ++k) {
+                int sourceX = 2 * x + k;
+                if (sourceX >= 0 && sourceX < width) {
+                    sum += WEIGHTS[k + 2] * column_sums[sourceX];
+                }
+            }
+            outRow[x] = (sum + 128) / 256;
+        }
+    }
+    return result;
+}
+
+// Bilinear upsampling of an image decimated by factor back to width x
+// height. Pixel x of the result lies at x / factor in the coarse image, and
+// positions past the last coarse pixel repeat it.
+GrayscaleImage upsample(const GrayscaleImage& coarse, int width, int height, int factor) {
+    int lastCol = coarse.get_width() - 1;
+    int lastRow = coarse.get_height() - 1;
+
+    // Source columns and weights are the same for every row
+    MemoryReservation scratch(width * (2 * sizeof(int) + sizeof(double)));
+    std::vector<int> left(width), right(width);
+    std::vector<double> weight(width);
+    for (int x = 0; x < width; ++x) {
+        left[x] = std::min(x / factor, lastCol);
+        right[x] = std::min(x / factor + 1, lastCol);
+        weight[x] = static_cast<double>(x % factor) / factor;
+    }
+
+    GrayscaleImage result(width, height);
+    for (int y = 0; y < height; ++y) {
+        const int* above = coarse.row(std::min(y / factor, lastRow));
+        const int* below = coarse.row(std::min(y / factor + 1, lastRow));
+        double t = static_cast<double>(y % factor) / factor;
+        int* outRow = result.row(y);
+        for (int x = 0; x < width; ++x) {
+            double top = above[left[x]] + (above[right[x]] - above[left[x]]) * weight[x];
+            double bottom = below[left[x]] + (below[right[x]] - below[left[x]]) * weight[x];
+            outRow[x] = static_cast<int>(std::floor(top + (bottom - top) * t + 0.5));
+        }
+    }
+    return result;
+}
+
+// Variance, in base pixels, of the binomial blurs applied down to a level
+double level_variance(int level) {
+    return (std::pow(4.0, level) - 1.0) / 3.0;
+}
+
+// Unsharp masking formula as in Filter: I_original + amount * (I_original - I_blur), clipped
+int sharpen(int original, int blurred, double amount) {
+    double newValue = original + amount * (original - static_cast<double>(blurred));
+    return static_cast<int>(std::min(std::max(newValue, 0.0), 255.0));
+}
+
+} // namespace
+
+// Constructor: count the levels; they are built on first use
+ImagePyramid::ImagePyramid(const GrayscaleImage& image) : base(image), level_count(1) {
+    int width = image.get_width();
+    int height = image.get_height();
+    while (width >= 2 && height >= 2) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        ++level_count;
+    }
+    levels.resize(level_count);
+    laplacians.resize(level_count);
+}
+
+// Get a Gaussian level, building it and the levels above it if needed
+const GrayscaleImage& ImagePyramid::get_level(int level) const {
+    if (level < 0 || level >= level_count) {
+        throw std::out_of_range("Pyramid level is out of range.");
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return level_locked(level);
+}
+
+const GrayscaleImage& ImagePyramid::level_locked(int level) const {
+    if (level == 0) {
+        return base;
+    }
+    if (!levels[level]) {
+        levels[level].reset(new GrayscaleImage(decimate(level_locked(level - 1))));
+    }
+    return *levels[level];
+}
+
+// Get a Laplacian level, building it if needed
+const GrayscaleImage& ImagePyramid::get_laplacian(int level) const {
+    if (level < 0 || level >= level_count) {
+        throw std::out_of_range("Pyramid level is out of range.");
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!laplacians[level]) {
+        const GrayscaleImage& fine = level_locked(level);
+        std::unique_ptr<GrayscaleImage> laplacian(new GrayscaleImage(fine));
+
+        // Subtract without clamping, so the difference can be added back exactly
+        if (level + 1 < level_count) {
+            GrayscaleImage expanded = expand(level_locked(level + 1), fine.get_width(), fine.get_height());
+            for (int y = 0; y < fine.get_height(); ++y) {
+                int* outRow = laplacian->row(y);
+                const int* expandedRow = expanded.row(y);
+                for (int x = 0; x < fine.get_width(); ++x) {
+                    outRow[x] -= expandedRow[x];
+                }
+            }
+        }
+        laplacians[level] = std::move(laplacian);
+    }
+    return *laplacians[level];
+}
+
+// Upsample a level to the size of the level below it
+GrayscaleImage ImagePyramid::expand(const GrayscaleImage& coarse, int width, int height) {
+    return upsample(coarse, width, height, 2);
+}
+
+// Add the Laplacian levels back up, from the coarsest to the finest
+GrayscaleImage ImagePyramid::collapse(const std::vector<GrayscaleImage>& laplacians) {
+    if (laplacians.empty()) {
+        throw std::invalid_argument("Collapsing a pyramid needs at least one level.");
+    }
+
+    GrayscaleImage result(laplacians.back());
+    for (int level = static_cast<int>(laplacians.size()) - 2; level >= 0; --level) {
+        const GrayscaleImage& band = laplacians[level];
+        if (result.get_width() != (band.get_width() + 1) / 2 || result.get_height() != (band.get_height() + 1) / 2) {
+            throw std::invalid_argument("Laplacian level sizes do not form a pyramid.");
+        }
+
+        // Add without clamping, so that unedited levels restore level 0 exactly
+        GrayscaleImage expanded = expand(result, band.get_width(), band.get_height());
+        for (int y = 0; y < band.get_height(); ++y) {
+            const int* bandRow = band.row(y);
+            int* outRow = expanded.row(y);
+            for (int x = 0; x < band.get_width(); ++x) {
+                outRow[x] += bandRow[x];
+            }
+        }
+        result = std::move(expanded);
+    }
+    return result;
+}
+
+// Approximate Gaussian smoothing of the image
+ApproximateResult ImagePyramid::gaussian_smoothing(int kernelSize, double sigma) const {
+    ApproximateResult result = approximate_blur(kernelSize, sigma);
+    measure_error(result, kernelSize, sigma, 0.0, false);
+    return result;
+}
+
+// Approximate unsharp masking of the image
+ApproximateResult ImagePyramid::unsharp_mask(int kernelSize, double sigma, double amount) const {
+    ApproximateResult result = approximate_blur(kernelSize, sigma);
+    for (int y = 0; y < base.get_height(); ++y) {
+        const int* originalRow = base.row(y);
+        int* outRow = result.image.row(y);
+        for (int x = 0; x < base.get_width(); ++x) {
+            outRow[x] = sharpen(originalRow[x], outRow[x], amount);
+        }
+    }
+    measure_error(result, kernelSize, sigma, amount, true);
+    return result;
+}
+
+// Blur a coarse level with what is left of sigma and upsample the result
+ApproximateResult ImagePyramid::approximate_blur(int kernelSize, double sigma) const {
+    // Upsampling by f blurs about as much as a triangle filter of half-width
+    // f, which has variance f^2 / 6
+    int level = 0;
+    double coarseSigma = 0.0;
+    for (int candidate = 1; candidate < level_count; ++candidate) {
+        double factor = static_cast<double>(1 << candidate);
+        double residual = sigma * sigma - level_variance(candidate) - factor * factor / 6.0;
+        if (residual <= 0.0 || std::sqrt(residual) / factor < MIN_COARSE_SIGMA) {
+            break;
+        }
+        level = candidate;
+        coarseSigma = std::sqrt(residual) / factor;
+    }
+
+    // Too small a sigma for any coarse level: run the exact filter
+    if (level == 0) {
+        GrayscaleImage image(base);
+        Filter::apply_gaussian_smoothing(image, kernelSize, sigma);
+        return {std::move(image), 0, 0, 0.0, 0};
+    }
+
+    GrayscaleImage coarse(get_level(level));
+    int coarseKernelSize = 2 * static_cast<int>(std::ceil(3.0 * coarseSigma)) + 1;
+    Filter::apply_gaussian_smoothing(coarse, coarseKernelSize, coarseSigma);
+    return {upsample(coarse, base.get_width(), base.get_height(), 1 << level), level, 0, 0.0, 0};
+}
+
+// Compare the result with the exact filter on evenly spaced rows, including
+// the first and last. Each exact row is computed by the Filter region
+// variant on a copy of the rows around it, with black rows beyond the edges.
+void ImagePyramid::measure_error(ApproximateResult& result, int kernelSize, double sigma, double amount,
+                                 bool sharpen_rows) const {
+    int width = base.get_width();
+    int height = base.get_height();
+    int rows = std::min(ERROR_SAMPLE_ROWS, height);
+    int radius = (kernelSize | 1) / 2;
+    long long total = 0;
+
+    for (int i = 0; i < rows; ++i) {
+        int y = rows == 1 ? 0 : static_cast<int>(static_cast<long long>(i) * (height - 1) / (rows - 1));
+
+        GrayscaleImage window(width, 2 * radius + 1);
+        for (int dy = -radius; dy <= radius; ++dy) {
+            if (y + dy >= 0 && y + dy < height) {
+                std::copy(base.row(y + dy), base.row(y + dy) + width, window.row(dy + radius));
+            }
+        }
+        Filter::apply_gaussian_smoothing(ImageView(window, radius, 0, 1, width), kernelSize, sigma);
+
+        const int* exactRow = static_cast<const GrayscaleImage&>(window).row(radius);
+        const int* originalRow = base.row(y);
+        const int* approximateRow = result.image.row(y);
+        for (int x = 0; x < width; ++x) {
+            int exact = sharpen_rows ? sharpen(originalRow[x], exactRow[x], amount) : exactRow[x];
+            int difference = std::abs(approximateRow[x] - exact);
+            result.max_error = std::max(result.max_error, difference);
+            total += difference;
+        }
+    }
+
+    result.sampled_pixels = rows * width;
+    result.mean_error = result.sampled_pixels > 0 ? static_cast<double>(total) / result.sampled_pixels : 0.0;
+}
@@ -0,0 +1,78 @@
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include "GrayscaleImage.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Result of an approximate filter, with its error measured against the
+// exact filter on a sample of rows
+struct ApproximateResult {
+    GrayscaleImage image;
+    int level;           // Pyramid level the filter ran on (0 means exact)
+    int max_error;       // Largest absolute pixel difference on the sampled rows
+    double mean_error;   // Mean absolute pixel difference on the sampled rows
+    int sampled_pixels;  // Number of pixels compared
+};
+
+// Gaussian/Laplacian pyramid of an image. Level 0 is the image itself and
+// each further level is blurred with the [1 4 6 4 1]/16 binomial filter and
+// decimated by 2; out-of-bounds pixels count as black, as in Filter. Levels
+// are built on first use and cached. The image must outlive the pyramid and
+// must not change while it is in use. Safe to share between threads.
+class ImagePyramid {
+public:
+    // Rows compared against the exact filter to estimate the error
+    static constexpr int ERROR_SAMPLE_ROWS = 8;
+
+    // Constructor: levels are added while both dimensions are at least 2
+    explicit ImagePyramid(const GrayscaleImage& image);
+
+    ImagePyramid(const ImagePyramid&) = delete;
+    ImagePyramid& operator=(const ImagePyramid&) = delete;
+
+    int get_level_count() const { return level_count; }
+
+    // Gaussian level (throws std::out_of_range for a missing level)
+    const GrayscaleImage& get_level(int level) const;
+
+    // Laplacian level: the Gaussian level minus expand() of the next level,
+    // so values may be negative. The last level is the coarsest Gaussian
+    // level itself, and collapse() of all Laplacian levels restores level 0
+    // exactly.
+    const GrayscaleImage& get_laplacian(int level) const;
+
+    // Bilinearly upsample a level by 2 to the size of the level below it
+    static GrayscaleImage expand(const GrayscaleImage& coarse, int width, int height);
+
+    // Rebuild level 0 from Laplacian levels, finest first: starting from the
+    // last, expand and add each finer level. The levels may have been
+    // edited; sums are not clamped. Throws std::invalid_argument if the
+    // list is empty or the sizes do not halve as pyramid levels do.
+    static GrayscaleImage collapse(const std::vector<GrayscaleImage>& laplacians);
+
+    // Approximate Filter::apply_gaussian_smoothing(image, kernelSize, sigma):
+    // blur the coarsest level whose own blur still leaves part of sigma
+    // over, with the remainder, then upsample bilinearly. Small sigmas run
+    // the exact filter. Works best when kernelSize covers +-3 sigma.
+    ApproximateResult gaussian_smoothing(int kernelSize, double sigma) const;
+
+    // Approximate unsharp masking with a Gaussian blur of the given sigma:
+    // original + amount * (original - blurred), clipped to [0, 255]
+    ApproximateResult unsharp_mask(int kernelSize, double sigma, double amount) const;
+
+private:
+    const GrayscaleImage& base;
+    int level_count;
+
+    mutable std::mutex mutex;
+    mutable std::vector<std::unique_ptr<GrayscaleImage>> levels;
+    mutable std::vector<std::unique_ptr<GrayscaleImage>> laplacians;
+
+    const GrayscaleImage& level_locked(int level) const;
+    ApproximateResult approximate_blur(int kernelSize, double sigma) const;
+    void measure_error(ApproximateResult& result, int kernelSize, double sigma, double amount, bool sharpen_rows) const;
+};
+
+#endif // IMAGE_PYRAMID_H
@@ -0,0 +1,41 @@
+#include "ImageView.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Constructor: view a region, which must lie inside the image
+ImageView::ImageView(GrayscaleImage& image, int row, int col, int height, int width)
+    : image(&image), origin_row(row), origin_col(col), height(height), width(width) {
+    if (row < 0 || col < 0 || height < 0 || width < 0 ||
+        row + height > image.get_height() || col + width > image.get_width()) {
+        throw std::out_of_range("View region is out of image bounds.");
+    }
+}
+
+// Constructor: view the whole image
+ImageView::ImageView(GrayscaleImage& image)
+    : image(&image), origin_row(0), origin_col(0), height(image.get_height()), width(image.get_width()) {}
+
+// Get a pixel relative to the view's origin
+int ImageView::get_pixel(int row, int col) const {
+    if (row < 0 || row >= height || col < 0 || col >= width) {
+        throw std::out_of_range("Pixel coordinates are out of view bounds.");
+    }
+    return image->get_pixel(origin_row + row, origin_col + col);
+}
+
+// Set a pixel relative to the view's origin
+void ImageView::set_pixel(int row, int col, int value) {
+    if (row < 0 || row >= height || col < 0 || col >= width) {
+        throw std::out_of_range("Pixel coordinates are out of view bounds.");
+    }
+    image->set_pixel(origin_row + row, origin_col + col, value);
+}
+
+// Copy the region into a new image
+GrayscaleImage ImageView::to_image() const {
+    GrayscaleImage result(width, height);
+    for (int r = 0; r < height; ++r) {
+        std::copy(row(r), row(r) + width, result.row(r));
+    }
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef IMAGE_VIEW_H
+#define IMAGE_VIEW_H
+
+#include "GrayscaleImage.h"
+
+// A non-owning rectangular region of a GrayscaleImage. The view shares the
+// parent's pixels: rows are the parent's stride() apart, and writes through
+// the view change the parent. The parent must outlive the view. Views can
+// be combined with + and - like images (see ImageExpression.h).
+class ImageView {
+private:
+    GrayscaleImage* image;
+    int origin_row, origin_col;
+    int height, width;
+
+public:
+    // Constructor: view the region of the given size starting at (row, col)
+    ImageView(GrayscaleImage& image, int row, int col, int height, int width);
+
+    // Constructor: view the whole image
+    ImageView(GrayscaleImage& image);
+
+    // Methods to get the view's size, origin and parent
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    int get_row() const { return origin_row; }
+    int get_col() const { return origin_col; }
+    int stride() const { return image->stride(); }
+    GrayscaleImage& parent() const { return *image; }
+
+    // Unchecked access to row r of the view
+    int* row(int r) { return image->row(origin_row + r) + origin_col; }
+    const int* row(int r) const {
+        return static_cast<const GrayscaleImage&>(*image).row(origin_row + r) + origin_col;
+    }
+
+    // Checked access relative to the view's origin
+    int get_pixel(int row, int col) const;
+    void set_pixel(int row, int col, int value);
+
+    // Copy the region out into a new image
+    GrayscaleImage to_image() const;
+};
+
+#endif // IMAGE_VIEW_H
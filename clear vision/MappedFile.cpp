@@ -0,0 +1,60 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CLEAR_VISION_HAVE_MMAP 1
+#endif
+
+// Constructor: map the file, falling back to reading it into memory
+MappedFile::MappedFile(const std::string& filename) : contents(nullptr), length(0), mapped(false) {
+#ifdef CLEAR_VISION_HAVE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error opening file: " + filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        if (info.st_size == 0) {
+            // Empty file: nothing to map
+            close(fd);
+            return;
+        }
+        void* address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            contents = static_cast<const char*>(address);
+            length = static_cast<std::size_t>(info.st_size);
+            mapped = true;
+        }
+    }
+    close(fd);
+
+    if (mapped) {
+        return;
+    }
+#endif
+
+    // Fallback: read the whole file into the buffer
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Error opening file: " + filename);
+    }
+    buffer.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    contents = buffer.data();
+    length = buffer.size();
+}
+
+// Destructor: unmap the file if it was mapped
+MappedFile::~MappedFile() {
+#ifdef CLEAR_VISION_HAVE_MMAP
+    if (mapped) {
+        munmap(const_cast<char*>(contents), length);
+    }
+#endif
+}
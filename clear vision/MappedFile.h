@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file. The file is memory-mapped where the
+// platform supports it and read into a buffer otherwise.
+class MappedFile {
+public:
+    // Map the file; throws std::runtime_error if it cannot be opened
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return contents; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* contents;
+    std::size_t length;
+    bool mapped;
+    std::vector<char> buffer;  // Used when the file is not mapped
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,78 @@
+#include "MemoryTracker.h"
+#include <atomic>
+
+namespace {
+
+std::atomic<std::size_t> total_bytes(0);
+std::atomic<std::size_t> category_bytes[MemoryTracker::CATEGORY_COUNT];
+std::atomic<std::size_t> peak(0);
+std::atomic<std::size_t> budget(0);
+
+// Raise the peak to at least the given total
+void update_peak(std::size_t total) {
+    std::size_t previous = peak.load();
+    while (total > previous && !peak.compare_exchange_weak(previous, total)) {
+    }
+}
+
+} // namespace
+
+// Reserve bytes against the budget, failing without side effects if they do not fit
+void MemoryTracker::acquire(std::size_t bytes, Category category) {
+    std::size_t limit = budget.load();
+    std::size_t current = total_bytes.load();
+    do {
+        if (limit != 0 && (current > limit || bytes > limit - current)) {
+            throw MemoryBudgetExceeded("Allocating " + std::to_string(bytes) + " bytes would exceed the memory budget of " +
+                                       std::to_string(limit) + " bytes (" + std::to_string(current) + " in use).");
+        }
+    } while (!total_bytes.compare_exchange_weak(current, current + bytes));
+
+    category_bytes[category] += bytes;
+    update_peak(current + bytes);
+}
+
+// Count bytes that have already been allocated
+void MemoryTracker::add(std::size_t bytes, Category category) {
+    std::size_t total = total_bytes += bytes;
+    category_bytes[category] += bytes;
+    update_peak(total);
+}
+
+// Forget freed bytes
+void MemoryTracker::release(std::size_t bytes, Category category) {
+    total_bytes -= bytes;
+    category_bytes[category] -= bytes;
+}
+
+// Check whether more bytes would fit in the budget
+bool MemoryTracker::would_fit(std::size_t bytes) {
+    std::size_t limit = budget.load();
+    std::size_t current = total_bytes.load();
+    return limit == 0 || (current <= limit && bytes <= limit - current);
+}
+
+std::size_t MemoryTracker::current_bytes() {
+    return total_bytes.load();
+}
+
+std::size_t MemoryTracker::current_bytes(Category category) {
+    return category_bytes[category].load();
+}
+
+std::size_t MemoryTracker::peak_bytes() {
+    return peak.load();
+}
+
+// Restart peak tracking from the current total
+void MemoryTracker::reset_peak() {
+    peak = total_bytes.load();
+}
+
+void MemoryTracker::set_budget(std::size_t bytes) {
+    budget = bytes;
+}
+
+std::size_t MemoryTracker::get_budget() {
+    return budget.load();
+}
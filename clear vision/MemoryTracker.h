@@ -0,0 +1,70 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Thrown when an allocation would take the process over its memory budget
+class MemoryBudgetExceeded : public std::runtime_error {
+public:
+    explicit MemoryBudgetExceeded(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Process-wide accounting of the bytes held by image buffers, secret image
+// arrays and temporary scratch space, with a peak tracker and an optional
+// budget. All functions are thread-safe.
+class MemoryTracker {
+public:
+    enum Category {
+        IMAGE_PIXELS,   // GrayscaleImage pixel buffers
+        SECRET_ARRAYS,  // SecretImage triangular arrays, raw or compressed
+        SCRATCH,        // Temporary buffers used by filters and I/O
+        CATEGORY_COUNT
+    };
+
+    // Account for bytes about to be allocated; throws MemoryBudgetExceeded
+    // (and accounts nothing) if they would exceed the budget
+    static void acquire(std::size_t bytes, Category category);
+
+    // Account for bytes that are already allocated, ignoring the budget
+    static void add(std::size_t bytes, Category category);
+
+    // Stop accounting for freed bytes
+    static void release(std::size_t bytes, Category category);
+
+    // Whether acquiring this many more bytes would stay within the budget
+    static bool would_fit(std::size_t bytes);
+
+    // Bytes currently held, in total or per category
+    static std::size_t current_bytes();
+    static std::size_t current_bytes(Category category);
+
+    // Highest total held since start-up or the last reset_peak()
+    static std::size_t peak_bytes();
+    static void reset_peak();
+
+    // Limit the total bytes held; 0 (the default) means unlimited
+    static void set_budget(std::size_t bytes);
+    static std::size_t get_budget();
+};
+
+// Accounts for a scratch buffer for the lifetime of the object
+class MemoryReservation {
+public:
+    MemoryReservation(std::size_t bytes, MemoryTracker::Category category = MemoryTracker::SCRATCH)
+        : bytes(bytes), category(category) {
+        MemoryTracker::acquire(bytes, category);
+    }
+
+    ~MemoryReservation() { MemoryTracker::release(bytes, category); }
+
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+private:
+    std::size_t bytes;
+    MemoryTracker::Category category;
+};
+
+#endif // MEMORY_TRACKER_H
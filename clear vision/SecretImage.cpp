@@ -1,7 +1,166 @@
 #include "SecretImage.h"
+#include "TriangularCodec.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include "MappedFile.h"
+#include "MemoryTracker.h"
+#include "AsyncIO.h"
+
+namespace {
+
+// Header of the compressed on-disk format
+const char COMPRESSED_MAGIC[4] = {'C', 'V', 'S', 'Z'};
+
+// Widest image whose element counts fit the int arithmetic used for the arrays
+const int MAX_COMPRESSED_WIDTH = 46340;
+
+void write_u32(std::ostream& out, std::uint32_t value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+// Read a little-endian u32 at cursor and advance past it
+std::uint32_t read_u32(const char*& cursor, const char* end, const std::string& filename) {
+    if (end - cursor < 4) {
+        throw std::runtime_error(filename + ": truncated file, incomplete compressed header.");
+    }
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(cursor[i])) << (8 * i);
+    }
+    cursor += 4;
+    return value;
+}
+
+// Read a length-prefixed compressed stream at cursor and advance past it.
+// The length is checked against the file before anything is allocated.
+std::vector<unsigned char> read_stream(const char*& cursor, const char* end, const std::string& filename) {
+    std::uint32_t size = read_u32(cursor, end, filename);
+    if (size > static_cast<std::size_t>(end - cursor)) {
+        throw std::runtime_error(filename + ": truncated file, compressed stream is cut short.");
+    }
+    std::vector<unsigned char> stream(cursor, cursor + size);
+    cursor += size;
+    return stream;
+}
+
+// Keep reconstructed values within [0, 255], as set_pixel would
+inline int clamp_pixel(int value) {
+    return std::min(std::max(value, 0), 255);
+}
+
+// Allocate both triangular arrays of a width x width image, counted
+// against the memory budget (throws MemoryBudgetExceeded when over it)
+void allocate_arrays(int width, int*& upper, int*& lower) {
+    std::size_t bytes = static_cast<std::size_t>(width) * width * sizeof(int);
+    MemoryTracker::acquire(bytes, MemoryTracker::SECRET_ARRAYS);
+    upper = nullptr;
+    try {
+        upper = new int[(static_cast<std::size_t>(width) * (width + 1)) / 2];
+        lower = new int[(static_cast<std::size_t>(width) * (width - 1)) / 2];
+    } catch (...) {
+        delete[] upper;
+        MemoryTracker::release(bytes, MemoryTracker::SECRET_ARRAYS);
+        throw;
+    }
+}
+
+// Free arrays from allocate_arrays (or adopted by the file constructor)
+void free_arrays(int width, int* upper, int* lower) {
+    if (upper == nullptr) {
+        return;
+    }
+    delete[] upper;
+    delete[] lower;
+    MemoryTracker::release(static_cast<std::size_t>(width) * width * sizeof(int), MemoryTracker::SECRET_ARRAYS);
+}
+
+std::size_t stream_bytes(const std::vector<unsigned char>& upper, const std::vector<unsigned char>& lower) {
+    return upper.size() + lower.size();
+}
+
+// Elements per line above which the upper and lower lines are parsed in parallel
+const std::size_t PARALLEL_PARSE_THRESHOLD = 1 << 15;
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// End of the line starting at begin (the newline itself, or end).
+// An empty file maps to null pointers, which memchr must not see.
+const char* find_line_end(const char* begin, const char* end) {
+    if (begin == end) {
+        return end;
+    }
+    const void* newline = std::memchr(begin, '\n', static_cast<std::size_t>(end - begin));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+// Parse exactly count blank-separated integers from one line
+void parse_line(const char* begin, const char* end, int* values, std::size_t count, const std::string& context) {
+    const char* cursor = begin;
+    for (std::size_t i = 0; i < count; ++i) {
+        while (cursor < end && is_blank(*cursor)) {
+            ++cursor;
+        }
+        if (cursor == end) {
+            throw std::runtime_error(context + ": truncated, expected " + std::to_string(count) +
+                                     " values but found " + std::to_string(i) + ".");
+        }
+        std::from_chars_result result = std::from_chars(cursor, end, values[i]);
+        if (result.ec != std::errc() || (result.ptr < end && !is_blank(*result.ptr))) {
+            throw std::runtime_error(context + ": malformed value at position " + std::to_string(i) + ".");
+        }
+        cursor = result.ptr;
+    }
+    while (cursor < end && is_blank(*cursor)) {
+        ++cursor;
+    }
+    if (cursor != end) {
+        throw std::runtime_error(context + ": more than the expected " + std::to_string(count) + " values.");
+    }
+}
+
+// Buffers formatted output and writes it to a stream in large chunks
+class ChunkWriter {
+public:
+    explicit ChunkWriter(std::ostream& out) : out(out), buffer(1 << 16), used(0) {}
+
+    void put_int(int value) {
+        if (used + 16 > buffer.size()) {
+            flush();
+        }
+        used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
+
+    void put_char(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+private:
+    std::ostream& out;
+    std::vector<char> buffer;
+    std::size_t used;
+};
+
+} // namespace
 
 // Constructor: split image into upper and lower triangular arrays
 SecretImage::SecretImage(const GrayscaleImage& image) {
@@ -9,25 +168,19 @@ SecretImage::SecretImage(const GrayscaleImage& image) {
     width = image.get_width();
     height = image.get_height();
 
-    // Calculate the number of elements in the upper and lower triangular matrices
-
-    int num_upper_elements = (width * (width + 1)) / 2;
-    int num_lower_elements = (width * (width - 1)) / 2;
-
-    // 1. Dynamically allocate the memory for the upper and lower triangular matrices.
-    upper_triangular = new int[num_upper_elements];
-    lower_triangular = new int[num_lower_elements];
+    // 1. Dynamically allocate the memory for the upper and lower triangular matrices
+    //    (width * (width + 1) / 2 and width * (width - 1) / 2 elements).
+    allocate_arrays(width, upper_triangular, lower_triangular);
 
     // 2. Fill both matrices with the pixels from the GrayscaleImage.
+    // Row i contributes columns i.. to the upper array and columns ..i-1 to the lower one.
     int upper_position = 0, lower_position = 0;
     for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            if (i <= j) {
-                upper_triangular[upper_position++] = image.get_pixel(i, j);
-            } else {
-                lower_triangular[lower_position++] = image.get_pixel(i, j);
-            }
-        }
+        const int* row = image.row(i);
+        std::copy(row, row + i, lower_triangular + lower_position);
+        std::copy(row + i, row + width, upper_triangular + upper_position);
+        lower_position += i;
+        upper_position += width - i;
     }
 }
 
@@ -44,6 +197,9 @@ SecretImage::SecretImage(int widht, int height, int* upper, int* lower)
 
     std::copy(upper, upper + num_upper_elements, upper_triangular);
     std::copy(lower, lower + num_lower_elements, lower_triangular);
+
+    // The arrays are already allocated, so they are counted without a budget check
+    MemoryTracker::add(static_cast<std::size_t>(width) * width * sizeof(int), MemoryTracker::SECRET_ARRAYS);
 }
 
 // Destructor: free the arrays
@@ -51,47 +207,76 @@ SecretImage::~SecretImage() {
 
     // Simply free the dynamically allocated memory
     // for the upper and lower triangular matrices.
-    delete[] upper_triangular;
-    delete[] lower_triangular;
+    free_arrays(width, upper_triangular, lower_triangular);
+    if (compressed) {
+        MemoryTracker::release(stream_bytes(upper_compressed, lower_compressed), MemoryTracker::SECRET_ARRAYS);
+    }
 }
 
 // Copy constructor
 SecretImage::SecretImage(const SecretImage& other) {
     width = other.width;
     height = other.height;
+    compressed = other.compressed;
+
+    // A compressed image is copied as its compressed streams
+    if (compressed) {
+        MemoryTracker::acquire(stream_bytes(other.upper_compressed, other.lower_compressed),
+                               MemoryTracker::SECRET_ARRAYS);
+        upper_compressed = other.upper_compressed;
+        lower_compressed = other.lower_compressed;
+        upper_triangular = nullptr;
+        lower_triangular = nullptr;
+        return;
+    }
 
     int num_upper_elements = (width * (width + 1)) / 2;
     int num_lower_elements = (width * (width - 1)) / 2;
 
-    upper_triangular = new int[num_upper_elements];  // Allocate memory
-    lower_triangular = new int[num_lower_elements];  // Allocate memory
+    allocate_arrays(width, upper_triangular, lower_triangular);  // Allocate memory
 
     std::copy(other.upper_triangular, other.upper_triangular + num_upper_elements, upper_triangular);
     std::copy(other.lower_triangular, other.lower_triangular + num_lower_elements, lower_triangular);
 }
 
+// Move constructor
+SecretImage::SecretImage(SecretImage&& other) noexcept
+    : upper_triangular(other.upper_triangular), lower_triangular(other.lower_triangular),
+      width(other.width), height(other.height),
+      upper_compressed(std::move(other.upper_compressed)), lower_compressed(std::move(other.lower_compressed)),
+      compressed(other.compressed) {
+    other.upper_triangular = nullptr;
+    other.lower_triangular = nullptr;
+    other.compressed = false;
+}
+
 // Copy assignment operator
 SecretImage& SecretImage::operator=(const SecretImage& other) {
     if (this == &other) {
         return *this;
     }
 
-    // Free existing memory
-    delete[] upper_triangular;
-    delete[] lower_triangular;
+    // Copy first, so that this image is left unchanged if the copy
+    // does not fit in the memory budget
+    SecretImage copy(other);
 
-    width = other.width;
-    height = other.height;
-
-    int num_upper_elements = (width * (width + 1)) / 2;
-    int num_lower_elements = (width * (width - 1)) / 2;
-
-    // Allocate new memory and copy elements
-    upper_triangular = new int[num_upper_elements];
-    lower_triangular = new int[num_lower_elements];
+    // Free existing memory
+    free_arrays(width, upper_triangular, lower_triangular);
+    if (compressed) {
+        MemoryTracker::release(stream_bytes(upper_compressed, lower_compressed), MemoryTracker::SECRET_ARRAYS);
+    }
 
-    std::copy(other.upper_triangular, other.upper_triangular + num_upper_elements, upper_triangular);
-    std::copy(other.lower_triangular, other.lower_triangular + num_lower_elements, lower_triangular);
+    // Take over the copy's storage; it is left owning nothing
+    width = copy.width;
+    height = copy.height;
+    compressed = copy.compressed;
+    upper_triangular = copy.upper_triangular;
+    lower_triangular = copy.lower_triangular;
+    upper_compressed = std::move(copy.upper_compressed);
+    lower_compressed = std::move(copy.lower_compressed);
+    copy.upper_triangular = nullptr;
+    copy.lower_triangular = nullptr;
+    copy.compressed = false;
 
     return *this;
 }
@@ -100,15 +285,27 @@ SecretImage& SecretImage::operator=(const SecretImage& other) {
 GrayscaleImage SecretImage::reconstruct() const {
     GrayscaleImage image(width, height);
 
+    // Compressed arrays are decoded straight into the image without expanding them
+    if (compressed) {
+        TriangularCodec::Decoder upper(upper_compressed.data(), upper_compressed.size());
+        TriangularCodec::Decoder lower(lower_compressed.data(), lower_compressed.size());
+        for (int i = 0; i < height; ++i) {
+            int* row = image.row(i);
+            for (int j = 0; j < width; ++j) {
+                row[j] = clamp_pixel(i <= j ? upper.next() : lower.next());
+            }
+        }
+        return image;
+    }
 
     int upper_position = 0, lower_position = 0;
     for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            if (i <= j) {
-                image.set_pixel(i, j, upper_triangular[upper_position++]);
-            } else {
-                image.set_pixel(i, j, lower_triangular[lower_position++]);
-            }
+        int* row = image.row(i);
+        for (int j = 0; j < i; ++j) {
+            row[j] = clamp_pixel(lower_triangular[lower_position++]);
+        }
+        for (int j = i; j < width; ++j) {
+            row[j] = clamp_pixel(upper_triangular[upper_position++]);
         }
     }
 
@@ -120,106 +317,327 @@ void SecretImage::save_back(const GrayscaleImage& image) {
 
     // Update the lower and upper triangular matrices
     // based on the GrayscaleImage given as the parameter.
+    // A compressed image is expanded for the update and compressed again.
+    // The rows are copied unchecked, so the size is checked once up front.
+    if (image.get_width() != width || image.get_height() != height) {
+        throw std::invalid_argument("Image size does not match the secret image.");
+    }
+    bool was_compressed = compressed;
+    expand();
 
+    // Row i contributes columns i.. to the upper array and columns ..i-1 to the lower one.
     int upper_position = 0, lower_position = 0;
     for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width; ++j) {
-            if (i <= j) {
-                upper_triangular[upper_position++] = image.get_pixel(i, j);
-            } else {
-                lower_triangular[lower_position++] = image.get_pixel(i, j);
-            }
-        }
+        const int* row = image.row(i);
+        std::copy(row, row + i, lower_triangular + lower_position);
+        std::copy(row + i, row + width, upper_triangular + upper_position);
+        lower_position += i;
+        upper_position += width - i;
+    }
+
+    if (was_compressed) {
+        compress();
     }
 }
 
 // Save the upper and lower triangular arrays to a file
 void SecretImage::save_to_file(const std::string& filename) {
 
-    std::ofstream outfile(filename);
+    std::ofstream outfile(filename, std::ios::binary);
 
     if (!outfile.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        return;
+        throw std::runtime_error("Error opening file: " + filename);
     }
 
+    ChunkWriter writer(outfile);
+
     // 1. Write width and height on the first line, separated by a single space.
 
-    outfile << width << " " << height << "\n";
+    writer.put_int(width);
+    writer.put_char(' ');
+    writer.put_int(height);
+    writer.put_char('\n');
 
-    // 2. Write the upper_triangular array to the second line.
-    // Ensure that the elements are space-separated.
-    // If there are 15 elements, write them as: "element1 element2 ... element15"
+    // 2. Write the upper_triangular array to the second line and the
+    // lower_triangular array to the third line, each element followed by a
+    // space. Compressed arrays are decoded while writing.
 
     int num_upper_elements = (width * (width + 1)) / 2;
-    for (int i = 0; i < num_upper_elements; ++i) {
-        outfile << upper_triangular[i] << " ";
+    int num_lower_elements = (width * (width - 1)) / 2;
+
+    auto write_line = [&writer](auto next_value, int count) {
+        for (int i = 0; i < count; ++i) {
+            writer.put_int(next_value());
+            writer.put_char(' ');
+        }
+    };
+
+    if (compressed) {
+        TriangularCodec::Decoder upper(upper_compressed.data(), upper_compressed.size());
+        TriangularCodec::Decoder lower(lower_compressed.data(), lower_compressed.size());
+        write_line([&upper]() { return upper.next(); }, num_upper_elements);
+        writer.put_char('\n');
+        write_line([&lower]() { return lower.next(); }, num_lower_elements);
+    } else {
+        const int* upper = upper_triangular;
+        const int* lower = lower_triangular;
+        write_line([&upper]() { return *upper++; }, num_upper_elements);
+        writer.put_char('\n');
+        write_line([&lower]() { return *lower++; }, num_lower_elements);
     }
-    outfile << "\n";
 
-    // 3. Write the lower_triangular array to the third line in a similar manner
-    // as the second line.
+    writer.flush();
 
-    int num_lower_elements = (width * (width - 1)) / 2;
-    for (int i = 0; i < num_lower_elements; ++i) {
-        outfile << lower_triangular[i] << " ";
+    if (!outfile) {
+        throw std::runtime_error("Error writing file: " + filename);
     }
+}
+
+// Save to a file on the I/O thread pool, from a snapshot of the arrays
+// (a compressed image is snapshotted compressed)
+std::future<void> SecretImage::save_to_file_async(const std::string& filename) const {
+    auto snapshot = std::make_shared<SecretImage>(*this);
+    return AsyncIO::submit([snapshot, filename]() mutable {
+        // Free the snapshot before the future becomes ready, even on failure
+        std::shared_ptr<SecretImage> image = std::move(snapshot);
+        image->save_to_file(filename);
+    });
+}
 
-    outfile.close();
+// Load a SecretImage on the I/O thread pool
+std::future<SecretImage> SecretImage::load_from_file_async(const std::string& filename) {
+    return AsyncIO::submit([filename]() { return load_from_file(filename); });
 }
 
-// Static function to load a SecretImage from a file
+// Static function to load a SecretImage from a file.
+// The file is memory-mapped and parsed with std::from_chars; for large
+// images the upper and lower lines are parsed on separate threads.
+// Truncated or malformed files raise std::runtime_error.
 SecretImage SecretImage::load_from_file(const std::string& filename) {
 
-    // 1. Open the file and read width and height from the first line, separated by a space.
-    // 2. Calculate the sizes of the upper and lower triangular arrays.
-    std::ifstream infile(filename);
+    MappedFile file(filename);
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
 
-    if (!infile.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        return SecretImage(0, 0, nullptr, nullptr);
+    // Files in the compressed format are recognized by their header
+    if (file.size() >= 4 && std::memcmp(cursor, COMPRESSED_MAGIC, 4) == 0) {
+        return load_compressed_from_file(filename);
     }
 
-    int w, h;
-    infile >> w >> h;
+    // 1. Read width and height from the first line, separated by a space.
 
-    int num_upper_elements = (w * (w + 1)) / 2;
-    int num_lower_elements = (w * (w - 1)) / 2;
+    const char* header_end = find_line_end(cursor, end);
+    if (header_end == end) {
+        throw std::runtime_error(filename + ": truncated file, missing header line.");
+    }
+    int dimensions[2];
+    parse_line(cursor, header_end, dimensions, 2, filename + " (header)");
+    int w = dimensions[0];
+    int h = dimensions[1];
+    if (w < 0 || h != w) {
+        throw std::runtime_error(filename + ": malformed header, expected a square image size.");
+    }
 
-    // 3. Allocate memory for both arrays.
+    // 2. Calculate the sizes of the upper and lower triangular arrays and
+    //    reject files too short to hold them before allocating anything.
 
-    int* upper = new int[num_upper_elements];
-    int* lower = new int[num_lower_elements];
+    std::size_t num_upper_elements = (static_cast<std::size_t>(w) * (w + 1)) / 2;
+    std::size_t num_lower_elements = (static_cast<std::size_t>(w) * (w - 1)) / 2;
+    if (num_upper_elements + num_lower_elements > file.size()) {
+        throw std::runtime_error(filename + ": truncated file, too short for a " +
+                                 std::to_string(w) + "x" + std::to_string(h) + " image.");
+    }
 
-    // 4. Read the upper_triangular array from the second line, space-separated.
+    // 3. Locate the upper and lower lines.
 
-    for (int i = 0; i < num_upper_elements; ++i) {
-        infile >> upper[i];
+    const char* upper_begin = header_end + 1;
+    const char* upper_end = find_line_end(upper_begin, end);
+    const char* lower_begin = upper_end == end ? end : upper_end + 1;
+    const char* lower_end = find_line_end(lower_begin, end);
+    for (const char* rest = lower_end; rest < end; ++rest) {
+        if (!is_blank(*rest) && *rest != '\n') {
+            throw std::runtime_error(filename + ": unexpected data after the lower triangular line.");
+        }
     }
 
-    // 5. Read the lower_triangular array from the third line, space-separated.
+    // 4. Parse both lines, splitting them across threads for large images.
 
-    for (int i = 0; i < num_lower_elements; ++i) {
-        infile >> lower[i];
+    // Fail cleanly up front if the arrays would not fit in the memory budget
+    if (!MemoryTracker::would_fit(static_cast<std::size_t>(w) * w * sizeof(int))) {
+        throw MemoryBudgetExceeded(filename + ": a " + std::to_string(w) + "x" + std::to_string(h) +
+                                   " secret image does not fit in the memory budget.");
     }
 
-    // 6. Close the file and return a SecretImage object initialized with the
-    //    width, height, and triangular arrays.
+    std::unique_ptr<int[]> upper(new int[num_upper_elements]);
+    std::unique_ptr<int[]> lower(new int[num_lower_elements]);
+
+    if (num_lower_elements >= PARALLEL_PARSE_THRESHOLD) {
+        std::future<void> lower_done = std::async(std::launch::async, [&]() {
+            parse_line(lower_begin, lower_end, lower.get(), num_lower_elements, filename + " (lower line)");
+        });
+        parse_line(upper_begin, upper_end, upper.get(), num_upper_elements, filename + " (upper line)");
+        lower_done.get();
+    } else {
+        parse_line(upper_begin, upper_end, upper.get(), num_upper_elements, filename + " (upper line)");
+        parse_line(lower_begin, lower_end, lower.get(), num_lower_elements, filename + " (lower line)");
+    }
 
-    infile.close();
+    // 5. Return a SecretImage object initialized with the width, height,
+    //    and triangular arrays.
 
-    SecretImage image(w, h, upper, lower);
-    return image;
+    return SecretImage(w, h, upper.release(), lower.release());
+}
+
+
+// Constructor: instantiate from compressed streams, keeping them compressed
+SecretImage::SecretImage(int width, int height, std::vector<unsigned char> upper, std::vector<unsigned char> lower)
+    : upper_triangular(nullptr), lower_triangular(nullptr), width(width), height(height),
+      upper_compressed(std::move(upper)), lower_compressed(std::move(lower)), compressed(true) {
+    MemoryTracker::add(stream_bytes(upper_compressed, lower_compressed), MemoryTracker::SECRET_ARRAYS);
+}
+
+// Compress both triangular arrays and free the raw arrays
+void SecretImage::compress() {
+    if (compressed) {
+        return;
+    }
+
+    int num_upper_elements = (width * (width + 1)) / 2;
+    int num_lower_elements = (width * (width - 1)) / 2;
+
+    upper_compressed = TriangularCodec::encode(upper_triangular, num_upper_elements);
+    lower_compressed = TriangularCodec::encode(lower_triangular, num_lower_elements);
+    MemoryTracker::add(stream_bytes(upper_compressed, lower_compressed), MemoryTracker::SECRET_ARRAYS);
+
+    free_arrays(width, upper_triangular, lower_triangular);
+    upper_triangular = nullptr;
+    lower_triangular = nullptr;
+    compressed = true;
 }
 
+// Restore the raw triangular arrays from the compressed streams
+void SecretImage::decompress() {
+    expand();
+}
+
+// Decode the compressed streams into freshly allocated arrays
+void SecretImage::expand() const {
+    if (!compressed) {
+        return;
+    }
+
+    int num_upper_elements = (width * (width + 1)) / 2;
+    int num_lower_elements = (width * (width - 1)) / 2;
+
+    int* upper;
+    int* lower;
+    allocate_arrays(width, upper, lower);
+    try {
+        TriangularCodec::decode(upper_compressed, upper, num_upper_elements);
+        TriangularCodec::decode(lower_compressed, lower, num_lower_elements);
+    } catch (...) {
+        free_arrays(width, upper, lower);
+        throw;
+    }
+
+    upper_triangular = upper;
+    lower_triangular = lower;
+    MemoryTracker::release(stream_bytes(upper_compressed, lower_compressed), MemoryTracker::SECRET_ARRAYS);
+    upper_compressed = std::vector<unsigned char>();
+    lower_compressed = std::vector<unsigned char>();
+    compressed = false;
+}
+
+// Returns whether the triangular arrays are currently held compressed.
+bool SecretImage::is_compressed() const {
+    return compressed;
+}
+
+// Returns the number of bytes held by the triangular arrays.
+std::size_t SecretImage::get_storage_size() const {
+    if (compressed) {
+        return upper_compressed.size() + lower_compressed.size();
+    }
+    return static_cast<std::size_t>(width) * width * sizeof(int);
+}
+
+// Save the triangular arrays in the compressed binary format:
+// magic, width, height, then the size and bytes of each compressed stream
+void SecretImage::save_compressed_to_file(const std::string& filename) const {
+    std::vector<unsigned char> upper_copy, lower_copy;
+    const std::vector<unsigned char>* upper = &upper_compressed;
+    const std::vector<unsigned char>* lower = &lower_compressed;
+    if (!compressed) {
+        upper_copy = TriangularCodec::encode(upper_triangular, (width * (width + 1)) / 2);
+        lower_copy = TriangularCodec::encode(lower_triangular, (width * (width - 1)) / 2);
+        upper = &upper_copy;
+        lower = &lower_copy;
+    }
+
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile.is_open()) {
+        throw std::runtime_error("Error opening file: " + filename);
+    }
+
+    outfile.write(COMPRESSED_MAGIC, 4);
+    write_u32(outfile, static_cast<std::uint32_t>(width));
+    write_u32(outfile, static_cast<std::uint32_t>(height));
+    write_u32(outfile, static_cast<std::uint32_t>(upper->size()));
+    outfile.write(reinterpret_cast<const char*>(upper->data()), upper->size());
+    write_u32(outfile, static_cast<std::uint32_t>(lower->size()));
+    outfile.write(reinterpret_cast<const char*>(lower->data()), lower->size());
+
+    if (!outfile) {
+        throw std::runtime_error("Error writing file: " + filename);
+    }
+}
+
+// Load a SecretImage from the compressed binary format; it stays compressed
+// Like load_from_file, malformed, truncated or non-square files raise
+// std::runtime_error, as do streams that do not decode to exactly the
+// expected number of elements.
+SecretImage SecretImage::load_compressed_from_file(const std::string& filename) {
+    MappedFile file(filename);
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
+
+    if (file.size() < 4 || std::memcmp(cursor, COMPRESSED_MAGIC, 4) != 0) {
+        throw std::runtime_error("Not a compressed secret image file: " + filename);
+    }
+    cursor += 4;
+
+    std::uint32_t w = read_u32(cursor, end, filename);
+    std::uint32_t h = read_u32(cursor, end, filename);
+    if (h != w || w > static_cast<std::uint32_t>(MAX_COMPRESSED_WIDTH)) {
+        throw std::runtime_error(filename + ": malformed header, expected a square image size of at most " +
+                                 std::to_string(MAX_COMPRESSED_WIDTH) + ".");
+    }
+
+    std::vector<unsigned char> upper = read_stream(cursor, end, filename);
+    std::vector<unsigned char> lower = read_stream(cursor, end, filename);
+    if (cursor != end) {
+        throw std::runtime_error(filename + ": unexpected data after the compressed streams.");
+    }
+
+    try {
+        TriangularCodec::check(upper, (static_cast<std::size_t>(w) * (w + 1)) / 2);
+        TriangularCodec::check(lower, (static_cast<std::size_t>(w) * (w - 1)) / 2);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+
+    return SecretImage(static_cast<int>(w), static_cast<int>(h), std::move(upper), std::move(lower));
+}
 
 // Returns a pointer to the upper triangular part of the secret image.
 int* SecretImage::get_upper_triangular() const {
+    expand();
     return upper_triangular;
 }
 
 // Returns a pointer to the lower triangular part of the secret image.
 int* SecretImage::get_lower_triangular() const {
+    expand();
     return lower_triangular;
 }
 
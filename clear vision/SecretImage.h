@@ -8,15 +8,28 @@
 #include <sstream>
 #include <string>
 #include <limits>
+#include <future>
+#include <vector>
 #include "GrayscaleImage.h"
 
 class SecretImage {
 
 private:
-    int *upper_triangular; // Üst üçgen kısmı (diyagonal dahil) için dizi
-    int *lower_triangular; // Alt üçgen kısmı (diyagonal hariç) için dizi
+    mutable int *upper_triangular; // Üst üçgen kısmı (diyagonal dahil) için dizi
+    mutable int *lower_triangular; // Alt üçgen kısmı (diyagonal hariç) için dizi
     int width, height;
 
+    // Sıkıştırılmış halde tutulan üçgen diziler (TriangularCodec biçiminde)
+    mutable std::vector<unsigned char> upper_compressed;
+    mutable std::vector<unsigned char> lower_compressed;
+    mutable bool compressed = false;
+
+    // Sıkıştırılmış akışlardan başlatma
+    SecretImage(int width, int height, std::vector<unsigned char> upper, std::vector<unsigned char> lower);
+
+    // Sıkıştırılmış dizileri gerektiğinde açar
+    void expand() const;
+
 public:
     // GrayscaleImage alır ve iki üçgen diziye böler
     SecretImage(const GrayscaleImage &image);
@@ -30,6 +43,9 @@ public:
     // Kopya yapıcı
     SecretImage(const SecretImage& other);
 
+    // Taşıma yapıcısı: dizileri devralır, other'ı boş bırakır
+    SecretImage(SecretImage&& other) noexcept;
+
     // Kopya atama operatörü
     SecretImage& operator=(const SecretImage& other);
 
@@ -37,15 +53,42 @@ public:
     GrayscaleImage reconstruct() const;
 
     // Filtreleme sonrası üçgen dizilere kaydeder
+    // (boyutlar farklıysa std::invalid_argument fırlatır)
     void save_back(const GrayscaleImage &image);
 
-    // Gizli bir görüntüyü belirtilen dosyaya kaydeder
+    // Gizli bir görüntüyü belirtilen dosyaya kaydeder (hata durumunda std::runtime_error fırlatır)
     void save_to_file(const std::string &filename);
 
     // Belirtilen dosyadan gizli bir görüntüyü okur
+    // (eksik veya bozuk dosyalarda std::runtime_error fırlatır)
     static SecretImage load_from_file(const std::string &filename);
 
+    // AsyncIO iş parçacığı havuzunda kaydetme ve okuma; hatalar future'ın
+    // get() çağrısında fırlatılır. Kaydetmeden önce görüntünün bir kopyası
+    // alınır, böylece görüntü yazma sürerken değiştirilebilir.
+    std::future<void> save_to_file_async(const std::string &filename) const;
+    static std::future<SecretImage> load_from_file_async(const std::string &filename);
+
+    // Üçgen dizileri sıkıştırır ve ham dizileri serbest bırakır
+    void compress();
+
+    // Sıkıştırılmış dizileri yeniden açar
+    void decompress();
+
+    // Dizilerin sıkıştırılmış halde olup olmadığını döndürür
+    bool is_compressed() const;
+
+    // Üçgen dizilerin bellekte kapladığı bayt sayısı
+    std::size_t get_storage_size() const;
+
+    // Gizli görüntüyü sıkıştırılmış ikili biçimde kaydeder
+    void save_compressed_to_file(const std::string &filename) const;
+
+    // Sıkıştırılmış ikili dosyadan gizli bir görüntüyü okur
+    static SecretImage load_compressed_from_file(const std::string &filename);
+
     // Özel değişkenler için getter ve setter fonksiyonları
+    // (sıkıştırılmış diziler bu çağrılarda açılır)
     int *get_upper_triangular() const;
     int *get_lower_triangular() const;
     int get_width() const;
@@ -0,0 +1,125 @@
+#include "TriangularCodec.h"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Append an unsigned value using 7 bits per byte, high bit marking continuation
+void write_varint(std::vector<unsigned char>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Map signed deltas to unsigned so that small magnitudes stay small.
+// Deltas between two ints need 33 bits, which leaves room for the run flag.
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+} // namespace
+
+// Encode values as delta tokens, collapsing runs of identical values
+std::vector<unsigned char> TriangularCodec::encode(const int* values, std::size_t count) {
+    std::vector<unsigned char> out;
+    out.reserve(count / 4 + 16);
+
+    int previous = 0;
+    std::size_t i = 0;
+    while (i < count) {
+        int value = values[i];
+        std::size_t run = 1;
+        while (i + run < count && values[i + run] == value) {
+            ++run;
+        }
+
+        std::uint64_t token = zigzag(static_cast<std::int64_t>(value) - previous) << 1;
+        if (run > 1) {
+            write_varint(out, token | 1);
+            write_varint(out, run - 1);
+        } else {
+            write_varint(out, token);
+        }
+
+        previous = value;
+        i += run;
+    }
+
+    return out;
+}
+
+// Decode a whole stream into a preallocated array
+void TriangularCodec::decode(const std::vector<unsigned char>& bytes, int* values, std::size_t count) {
+    Decoder decoder(bytes.data(), bytes.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = decoder.next();
+    }
+}
+
+// Walk the tokens of a stream, counting runs without expanding them
+void TriangularCodec::check(const std::vector<unsigned char>& bytes, std::size_t count) {
+    Decoder decoder(bytes.data(), bytes.size());
+    std::size_t decoded = 0;
+    while (decoder.position != decoder.end) {
+        if (decoded == count) {
+            throw std::runtime_error("Compressed triangular data holds more values than expected.");
+        }
+        decoder.next();
+        ++decoded;
+        if (decoder.pending_repeats > count - decoded) {
+            throw std::runtime_error("Compressed triangular data holds more values than expected.");
+        }
+        decoded += static_cast<std::size_t>(decoder.pending_repeats);
+        decoder.pending_repeats = 0;
+    }
+    if (decoded != count) {
+        throw std::runtime_error("Compressed triangular data is truncated.");
+    }
+}
+
+TriangularCodec::Decoder::Decoder(const unsigned char* data, std::size_t size)
+    : position(data), end(data + size), previous(0), pending_repeats(0) {}
+
+// Produce the next value, either from a pending run or from a new token
+int TriangularCodec::Decoder::next() {
+    if (pending_repeats > 0) {
+        --pending_repeats;
+        return previous;
+    }
+
+    std::uint64_t token = read_varint();
+    std::int64_t value = previous + unzigzag(token >> 1);
+    if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("Compressed triangular data is malformed.");
+    }
+    previous = static_cast<int>(value);
+    if (token & 1) {
+        pending_repeats = read_varint();
+    }
+    return previous;
+}
+
+// Read one varint, rejecting truncated or oversized encodings
+std::uint64_t TriangularCodec::Decoder::read_varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position == end) {
+            throw std::runtime_error("Compressed triangular data is truncated.");
+        }
+        unsigned char byte = *position++;
+        if (shift == 63 && byte > 1) {
+            break;  // More than 64 bits
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Compressed triangular data is malformed.");
+}
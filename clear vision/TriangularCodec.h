@@ -0,0 +1,45 @@
+#ifndef TRIANGULAR_CODEC_H
+#define TRIANGULAR_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact encoding for the triangular pixel arrays of a SecretImage.
+// Each value is stored as the zigzag-encoded difference from the previous
+// value in a varint token; the token's lowest bit marks a run, in which case
+// a second varint gives how many more times the value repeats. Tokens are
+// 64-bit, so any int, and any difference between two ints, can be stored.
+class TriangularCodec {
+public:
+    // Encode count values into a byte stream
+    static std::vector<unsigned char> encode(const int* values, std::size_t count);
+
+    // Decode exactly count values from a byte stream into values
+    static void decode(const std::vector<unsigned char>& bytes, int* values, std::size_t count);
+
+    // Verify that a byte stream decodes to exactly count values, without
+    // storing them; throws std::runtime_error otherwise
+    static void check(const std::vector<unsigned char>& bytes, std::size_t count);
+
+    // Decodes a byte stream one value at a time
+    class Decoder {
+    public:
+        Decoder(const unsigned char* data, std::size_t size);
+
+        // Return the next value; throws if the stream is exhausted
+        int next();
+
+    private:
+        friend class TriangularCodec;
+
+        std::uint64_t read_varint();
+
+        const unsigned char* position;
+        const unsigned char* end;
+        int previous;
+        std::uint64_t pending_repeats;
+    };
+};
+
+#endif // TRIANGULAR_CODEC_H
@@ -0,0 +1,42 @@
+// Golden-output regression harness.
+//
+// Usage: golden_harness [--samples DIR] [--baseline FILE] [--threshold FRACTION]
+//                       [--noise-floor SECONDS] [--tolerance PIXELS] [--repeat N] [--record]
+//
+// Runs every operation against the goldens in sample_io/ and exits non-zero
+// if an output is wrong or an operation is slower than the baseline by more
+// than the threshold (ignoring differences below the noise floor). --record
+// writes a new baseline instead, unless an output is wrong.
+
+#include "GoldenHarness.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    GoldenHarness::Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--record") == 0) {
+            options.record = true;
+        } else if (std::strcmp(argv[i], "--samples") == 0 && has_value) {
+            options.sample_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+            options.baseline_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) {
+            options.slowdown_threshold = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--noise-floor") == 0 && has_value) {
+            options.noise_floor = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            options.tolerance = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value) {
+            options.repetitions = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    return GoldenHarness::run(options, std::cout) ? 0 : 1;
+}